@@ -0,0 +1,109 @@
+/*
+ * animation.c
+ *
+ * Written by Matt Burton
+ */
+
+#include "animation.h"
+#include "framebuffer.h"
+#include "palette.h"
+#include "scrolling_char_display.h"
+#include <avr/pgmspace.h>
+
+// The timeline being played (0 if none), a RAM copy of the current step
+// and how far through that step we are.
+static const AnimationStep* timeline;
+static AnimationStep step;
+static uint8_t step_started;
+static uint8_t repeats_done;
+static uint32_t last_action_time;
+
+static void load_step(void) {
+	memcpy_P(&step, timeline, sizeof(AnimationStep));
+	step_started = 0;
+	repeats_done = 0;
+}
+
+static void next_step(void) {
+	timeline++;
+	load_step();
+}
+
+void animation_start(const AnimationStep* new_timeline) {
+	timeline = new_timeline;
+	load_step();
+}
+
+void animation_stop(void) {
+	timeline = 0;
+}
+
+// Begin the current step. Returns 1 if the step is already complete.
+static uint8_t begin_step(uint32_t current_time) {
+	step_started = 1;
+	last_action_time = current_time;
+	switch(step.action) {
+		case ANIM_SCROLL_TEXT:
+			set_scrolling_display_text_P(step.text, step.colour);
+			break;
+		case ANIM_FADE:
+			palette_fade_to(step.count, step.interval);
+			break;
+		case ANIM_RESET:
+			init_palette();
+			framebuffer_clear();
+			return 1;
+	}
+	return 0;
+}
+
+// Perform the current step if its interval has passed. Returns 1 when
+// the step is complete.
+static uint8_t continue_step(uint32_t current_time) {
+	if(step.action == ANIM_FADE) {
+		// The palette times the fade itself
+		palette_step(current_time);
+		framebuffer_flush();
+		return !palette_fading();
+	}
+	if(current_time < last_action_time + step.interval) {
+		return 0;
+	}
+	last_action_time = current_time;
+	switch(step.action) {
+		case ANIM_SHIFT_LEFT:
+		case ANIM_SHIFT_RIGHT:
+		case ANIM_SHIFT_UP:
+		case ANIM_SHIFT_DOWN:
+			// Through the framebuffer, so its shadow copy (and anything
+			// streaming it) stays in step with the display. (The actions
+			// are in the same order as the shift directions.)
+			framebuffer_shift(SHIFT_LEFT + step.action - ANIM_SHIFT_LEFT);
+			framebuffer_flush();
+			break;
+		case ANIM_SCROLL_TEXT:
+			return !scroll_display();
+		case ANIM_WAIT:
+			return 1;
+	}
+	return ++repeats_done >= step.count;
+}
+
+uint8_t animation_step(uint32_t current_time) {
+	if(!timeline) {
+		return 0;
+	}
+	// Steps which complete immediately move straight on to the next one
+	while(step.action != ANIM_END) {
+		if(!step_started) {
+			if(!begin_step(current_time)) {
+				return 1;
+			}
+		} else if(!continue_step(current_time)) {
+			return 1;
+		}
+		next_step();
+	}
+	timeline = 0;
+	return 0;
+}
@@ -0,0 +1,68 @@
+/*
+ * animation.h
+ *
+ * Author: Matt Burton
+ *
+ * Plays LED matrix animations described as a timeline of steps stored in
+ * program memory. animation_step() is polled from the main loop (like 
+ * display_data()) and never blocks, so the caller can keep checking the
+ * buttons while an animation plays.
+ *
+ * A timeline is an array of AnimationStep ending with an ANIM_END step,
+ * e.g.
+ *	static const AnimationStep timeline[] PROGMEM = {
+ *		{ANIM_SHIFT_RIGHT, 16, 100, 0, 0},
+ *		{ANIM_SCROLL_TEXT, 0, 100, text, COLOUR_GREEN},
+ *		{ANIM_END, 0, 0, 0, 0}
+ *	};
+ */
+
+#ifndef ANIMATION_H_
+#define ANIMATION_H_
+
+#include <stdint.h>
+#include "pixel_colour.h"
+
+// The actions a step can perform. For each step "count" and "interval"
+// (milliseconds) mean:
+//	ANIM_SHIFT_*	- shift the display count times, interval apart
+//	ANIM_SCROLL_TEXT- scroll text (a string in program memory) across the
+//					  display in colour, one column every interval
+//	ANIM_FADE		- fade the brightness to level count (0 to 
+//					  BRIGHTNESS_MAX), one level every interval
+//	ANIM_WAIT		- do nothing for interval
+//	ANIM_RESET		- forget the framebuffer contents, clear the display 
+//					  and return to full brightness
+//	ANIM_END		- the end of the timeline
+typedef enum {
+	ANIM_END,
+	ANIM_SHIFT_LEFT,
+	ANIM_SHIFT_RIGHT,
+	ANIM_SHIFT_UP,
+	ANIM_SHIFT_DOWN,
+	ANIM_SCROLL_TEXT,
+	ANIM_FADE,
+	ANIM_WAIT,
+	ANIM_RESET
+} AnimationAction;
+
+typedef struct {
+	uint8_t action;
+	uint8_t count;
+	uint16_t interval;
+	const char* text;
+	PixelColour colour;
+} AnimationStep;
+
+// Start playing the given timeline (which must be in program memory)
+// from its first step. Any animation already playing is abandoned.
+void animation_start(const AnimationStep* timeline);
+
+// Stop the current animation (if any).
+void animation_stop(void);
+
+// Perform any work due for the current step. Returns 1 while the 
+// animation is still playing, 0 once ANIM_END has been reached.
+uint8_t animation_step(uint32_t current_time);
+
+#endif /* ANIMATION_H_ */
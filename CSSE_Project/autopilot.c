@@ -0,0 +1,101 @@
+/*
+ * autopilot.c
+ *
+ * Written by Matt Burton
+ */
+
+#include "autopilot.h"
+#include "buttons.h"
+#include "game.h"
+
+// The buttons play_game() uses for each move
+#define BUTTON_LEFT		3
+#define BUTTON_FIRE		2
+#define BUTTON_RIGHT	0
+
+// The base's footprint shifted one column left or right. Shifting left
+// off column 0 can't happen as the base can't move there anyway.
+#define FOOTPRINT_LEFT(footprint)	((footprint) >> 1)
+#define FOOTPRINT_RIGHT(footprint)	((footprint) << 1)
+
+static uint8_t mode;
+static uint32_t last_decision_time;
+static uint16_t presses;
+
+static int8_t decide(void);
+
+void autopilot_set_mode(uint8_t new_mode) {
+	mode = new_mode;
+	last_decision_time = 0;
+	presses = 0;
+}
+
+uint8_t autopilot_mode(void) {
+	return mode;
+}
+
+uint16_t autopilot_presses(void) {
+	return presses;
+}
+
+int8_t autopilot_input(uint32_t current_time) {
+	int8_t button;
+	
+	if(mode == AUTOPILOT_OFF || 
+			current_time < last_decision_time + AUTOPILOT_INTERVAL_MS) {
+		return NO_BUTTON_PUSHED;
+	}
+	last_decision_time = current_time;
+	button = decide();
+	if(button != NO_BUTTON_PUSHED) {
+		presses++;
+	}
+	return button;
+}
+
+static int8_t decide(void) {
+	int8_t base = get_base_position();
+	FieldRow footprint = get_base_footprint();
+	FieldRow danger = 0;
+	FieldRow targets = 0;
+	FieldRow row;
+	
+	// danger - the columns with an asteroid just above (or beside) the 
+	// base. targets - the columns with an asteroid anywhere.
+	for(uint8_t y = 0; y < FIELD_HEIGHT; y++) {
+		row = get_asteroid_row(y);
+		if(y < AUTOPILOT_DANGER_ROWS) {
+			danger |= row;
+		}
+		targets |= row;
+	}
+	
+	if(danger & footprint) {
+		// Something is about to land on us - step aside if there's a clear
+		// column, otherwise try to shoot our way out.
+		if(base > 0 && !(danger & FOOTPRINT_LEFT(footprint))) {
+			return BUTTON_LEFT;
+		}
+		if(base < FIELD_WIDTH - 1 && !(danger & FOOTPRINT_RIGHT(footprint))) {
+			return BUTTON_RIGHT;
+		}
+		return BUTTON_FIRE;
+	}
+	if(targets & FIELD_BIT(base)) {
+		return BUTTON_FIRE;
+	}
+	// Head for the nearest target, unless that means stepping under 
+	// something
+	for(int8_t distance = 1; distance <= AUTOPILOT_SEARCH; distance++) {
+		if(base - distance >= 0 && (targets & FIELD_BIT(base - distance))) {
+			return (danger & FOOTPRINT_LEFT(footprint)) ? 
+					NO_BUTTON_PUSHED : BUTTON_LEFT;
+		}
+		if(base + distance < FIELD_WIDTH && 
+				(targets & FIELD_BIT(base + distance))) {
+			return (danger & FOOTPRINT_RIGHT(footprint)) ? 
+					NO_BUTTON_PUSHED : BUTTON_RIGHT;
+		}
+	}
+	return NO_BUTTON_PUSHED;
+}
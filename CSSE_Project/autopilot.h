@@ -0,0 +1,55 @@
+/*
+ * autopilot.h
+ *
+ * Author: Matt Burton
+ *
+ * A computer player. autopilot_input() looks at the game field and 
+ * returns a button number (as button_pushed() would - see buttons.h),
+ * which play_game() then handles exactly like a real button push. It 
+ * dodges asteroids about to land on the base, fires at asteroids above
+ * the base and otherwise heads for the nearest column with an asteroid
+ * in it.
+ *
+ * Each decision reads every row of the field once and then looks at 
+ * most AUTOPILOT_SEARCH columns either side of the base, so it takes
+ * the same (small) time however many asteroids there are. Decisions are
+ * made at most once every AUTOPILOT_INTERVAL_MS.
+ *
+ * The autopilot is used for soak testing (AUTOPILOT_ON - real input 
+ * still works) and for attract mode on the splash screen 
+ * (AUTOPILOT_ATTRACT - real input ends the demonstration game).
+ */
+
+#ifndef AUTOPILOT_H_
+#define AUTOPILOT_H_
+
+#include <stdint.h>
+
+#define AUTOPILOT_OFF		0
+#define AUTOPILOT_ON		1
+#define AUTOPILOT_ATTRACT	2
+
+#define AUTOPILOT_INTERVAL_MS	150
+#define AUTOPILOT_SEARCH		8
+
+// Asteroids in the bottom AUTOPILOT_DANGER_ROWS rows of the field (the
+// base's rows and the few just above them) are dodged
+#define AUTOPILOT_DANGER_ROWS	5
+
+// How long the splash screen waits for a button before starting a
+// demonstration game
+#define AUTOPILOT_IDLE_MS	15000
+
+void autopilot_set_mode(uint8_t mode);
+uint8_t autopilot_mode(void);
+
+// Returns the button the autopilot pushes (0 to 3), or NO_BUTTON_PUSHED
+// if it is off, it is not yet time for another decision or there is
+// nothing to do.
+int8_t autopilot_input(uint32_t current_time);
+
+// The number of buttons the autopilot has pushed since its mode was 
+// last set. (A check that its input is really reaching the game.)
+uint16_t autopilot_presses(void);
+
+#endif /* AUTOPILOT_H_ */
@@ -0,0 +1,93 @@
+/*
+ * entity.c
+ *
+ * Written by Matt Burton
+ */
+
+#include "entity.h"
+
+static GamePosition position_buffers[2][MAX_ENTITIES];
+GamePosition* entity_position = position_buffers[0];
+uint8_t entity_fraction[MAX_ENTITIES];
+uint16_t entity_velocity[MAX_ENTITIES];
+uint8_t entity_type[MAX_ENTITIES];
+uint8_t entity_variant[MAX_ENTITIES];
+uint8_t entity_flags[MAX_ENTITIES];
+
+uint8_t entity_live[MAX_ENTITIES];
+uint8_t num_entities;
+
+// live_index[slot] - where the slot appears in entity_live[] (only
+// meaningful for live slots).
+// free_slots - a stack of the unused slots, free_slots[0] to
+// free_slots[num_free - 1].
+// generation - per slot, incremented each time the slot is freed.
+static uint8_t live_index[MAX_ENTITIES];
+static uint8_t free_slots[MAX_ENTITIES];
+static uint8_t num_free;
+static uint8_t generation[MAX_ENTITIES];
+
+void entity_pool_clear(void) {
+	for(uint8_t slot = 0; slot < MAX_ENTITIES; slot++) {
+		if(slot < num_entities) {
+			// Invalidate any handles still held to live entities
+			generation[entity_live[slot]]++;
+		}
+		free_slots[slot] = MAX_ENTITIES - 1 - slot;
+	}
+	num_free = MAX_ENTITIES;
+	num_entities = 0;
+}
+
+EntityHandle entity_create(uint8_t type) {
+	uint8_t slot;
+
+	if(num_free == 0) {
+		return INVALID_ENTITY;
+	}
+	slot = free_slots[--num_free];
+	entity_position[slot] = 0;
+	entity_fraction[slot] = 0;
+	entity_velocity[slot] = 0;
+	entity_type[slot] = type;
+	entity_variant[slot] = 0;
+	entity_flags[slot] = 0;
+	live_index[slot] = num_entities;
+	entity_live[num_entities++] = slot;
+	return entity_handle(slot);
+}
+
+void entity_destroy(EntityHandle handle) {
+	uint8_t slot = ENTITY_SLOT(handle);
+	uint8_t last;
+
+	if(!entity_is_live(handle)) {
+		return;
+	}
+	// Move the last live slot into this one's place in the list
+	last = entity_live[--num_entities];
+	entity_live[live_index[slot]] = last;
+	live_index[last] = live_index[slot];
+	generation[slot]++;
+	free_slots[num_free++] = slot;
+}
+
+uint8_t entity_is_live(EntityHandle handle) {
+	uint8_t slot = ENTITY_SLOT(handle);
+
+	return slot < MAX_ENTITIES && handle == entity_handle(slot) &&
+			live_index[slot] < num_entities && entity_live[live_index[slot]] == slot;
+}
+
+EntityHandle entity_handle(uint8_t slot) {
+	return ((uint16_t)generation[slot] << 8) | slot;
+}
+
+GamePosition* entity_next_positions(void) {
+	return (entity_position == position_buffers[0]) ?
+			position_buffers[1] : position_buffers[0];
+}
+
+void entity_swap_positions(void) {
+	entity_position = entity_next_positions();
+}
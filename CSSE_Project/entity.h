@@ -0,0 +1,92 @@
+/*
+ * entity.h
+ *
+ * Author: Matt Burton
+ *
+ * A fixed size pool of game objects (asteroids and projectiles). Each
+ * entity occupies a slot, and its data is held in one array per field
+ * (position, velocity, type, ...) indexed by slot number. The slots in
+ * use are also listed, packed together, in entity_live[] so that the
+ * live entities can be visited with one simple loop:
+ *
+ *	for(uint8_t i = 0; i < num_entities; i++) {
+ *		slot = entity_live[i];
+ *		...
+ *	}
+ *
+ * Creating and destroying an entity takes constant time and never moves
+ * any other entity to a different slot. (Destroying an entity does
+ * reorder entity_live[] - loops that destroy entities as they go should
+ * run backwards through the list.)
+ *
+ * Entities are referred to by handles made up of the slot number and a
+ * generation count for the slot, which changes every time the slot is
+ * freed. A handle to an entity that has been destroyed is therefore
+ * recognised as stale, even if its slot has been reused.
+ */
+
+#ifndef ENTITY_H_
+#define ENTITY_H_
+
+#include <stdint.h>
+#include "game.h"
+
+#define MAX_ENTITIES (MAX_ASTEROIDS + MAX_PROJECTILES)
+
+typedef uint16_t EntityHandle;
+#define ENTITY_SLOT(handle)		((uint8_t)(handle))
+#define INVALID_ENTITY			0xFFFF
+
+// Entity types
+#define ENTITY_ASTEROID		0
+#define ENTITY_PROJECTILE	1
+
+// Entity flags
+#define ENTITY_FLAG_GONE	0x01	// Removed from the field, not yet destroyed
+
+// Entity data, indexed by slot number.
+// entity_position - position on the game field (see GAME_POSITION in
+//   game.h). This points to one of two buffers - see
+//   entity_next_positions() below.
+// entity_fraction - fractional part of the y position (1/256ths of a
+//   cell)
+// entity_velocity - 8.8 fixed point cells per tick
+// entity_type - ENTITY_ASTEROID etc.
+// entity_variant - meaning depends on type (e.g. asteroid shape)
+// entity_flags - ENTITY_FLAG_... values
+extern GamePosition* entity_position;
+extern uint8_t entity_fraction[MAX_ENTITIES];
+extern uint16_t entity_velocity[MAX_ENTITIES];
+extern uint8_t entity_type[MAX_ENTITIES];
+extern uint8_t entity_variant[MAX_ENTITIES];
+extern uint8_t entity_flags[MAX_ENTITIES];
+
+// The slots of the live entities, entity_live[0] to
+// entity_live[num_entities - 1], in no particular order.
+extern uint8_t entity_live[MAX_ENTITIES];
+extern uint8_t num_entities;
+
+// Destroy all entities.
+void entity_pool_clear(void);
+
+// Create an entity of the given type. All of its data except the type
+// is zero. Returns INVALID_ENTITY if the pool is full.
+EntityHandle entity_create(uint8_t type);
+
+// Destroy an entity. Stale handles are ignored.
+void entity_destroy(EntityHandle handle);
+
+// Returns 1 if the handle refers to a live entity, 0 otherwise.
+uint8_t entity_is_live(EntityHandle handle);
+
+// Returns the handle of the entity currently in the given slot.
+EntityHandle entity_handle(uint8_t slot);
+
+// Positions are double buffered so that all entities can be moved at
+// once. entity_next_positions() returns the spare buffer - once it has
+// been filled in (for every live entity) entity_swap_positions() makes
+// it the current one.
+GamePosition* entity_next_positions(void);
+void entity_swap_positions(void);
+
+#endif /* ENTITY_H_ */
@@ -0,0 +1,334 @@
+/*
+ * framebuffer.c
+ *
+ * Written by Matt Burton
+ */
+
+#include "framebuffer.h"
+#include "ledmatrix.h"
+#include "palette.h"
+#include "orientation.h"
+
+// A pixel update costs 3 SPI bytes (command, position, colour) and a
+// column update costs 2 + MATRIX_NUM_ROWS bytes. Once this many pixels in
+// a column are dirty it is cheaper to resend the whole column.
+#define PIXEL_UPDATE_BYTES	3
+#define COLUMN_UPDATE_BYTES	(2 + MATRIX_NUM_ROWS)
+#define COLUMN_THRESHOLD	((COLUMN_UPDATE_BYTES + PIXEL_UPDATE_BYTES - 1) / PIXEL_UPDATE_BYTES)
+#define ROW_UPDATE_BYTES	(2 + MATRIX_NUM_COLUMNS)
+
+// The shadow copy of the display (all panels), indexed the same way as
+// MatrixData.
+static PixelColour frame[MATRIX_TOTAL_COLUMNS][MATRIX_NUM_ROWS];
+
+// The layer each pixel was drawn on - two bits per pixel, bits 2y and 
+// 2y+1 of frame_layer[x] for pixel (x,y), so a column of 0 is all 
+// LAYER_FIELD - and the layer new pixels are drawn on.
+static uint16_t frame_layer[MATRIX_TOTAL_COLUMNS];
+static uint8_t current_layer;
+#define LAYER_BITS			2
+#define LAYER_MASK			((1 << LAYER_BITS) - 1)
+#define GET_LAYER(x, y)		((frame_layer[x] >> (LAYER_BITS * (y))) & LAYER_MASK)
+#define SET_LAYER(x, y, layer)	(frame_layer[x] = (frame_layer[x] & \
+		~((uint16_t)LAYER_MASK << (LAYER_BITS * (y)))) | \
+		((uint16_t)(layer) << (LAYER_BITS * (y))))
+
+#if NUM_LAYERS > (1 << LAYER_BITS) || MATRIX_NUM_ROWS * LAYER_BITS > 16
+#error "frame_layer can't hold the layers"
+#endif
+
+// One byte per column - bit y is set if pixel (x,y) has changed since
+// the last flush. Bit p of dirty_panels is set if any column on panel
+// p is dirty. Bit y of dirty_rows is set if row y is to be sent in full
+// on every panel (after a shift).
+static uint8_t dirty[MATRIX_TOTAL_COLUMNS];
+static uint8_t dirty_panels;
+static uint8_t dirty_rows;
+
+// One byte per column for each viewer - bit y is set if pixel (x,y) has
+// changed colour since the viewer last sent it (see framebuffer.h).
+static uint8_t unsent[NUM_VIEWERS][MATRIX_TOTAL_COLUMNS];
+
+static void mark_dirty(uint8_t x, uint8_t y) {
+	dirty[x] |= (1 << y);
+	dirty_panels |= (1 << (x / MATRIX_NUM_COLUMNS));
+}
+
+static void mark_unsent(uint8_t x, uint8_t rows) {
+	for(uint8_t viewer = 0; viewer < NUM_VIEWERS; viewer++) {
+		unsent[viewer][x] |= rows;
+	}
+}
+
+void framebuffer_clear(void) {
+	for(uint8_t x = 0; x < MATRIX_TOTAL_COLUMNS; x++) {
+		set_matrix_column_to_colour(frame[x], COLOUR_BLACK);
+		frame_layer[x] = 0;
+		dirty[x] = 0;
+		mark_unsent(x, 0xFF);
+	}
+	dirty_panels = 0;
+	dirty_rows = 0;
+	current_layer = LAYER_FIELD;
+	ledmatrix_clear();
+}
+
+void framebuffer_select_layer(uint8_t layer) {
+	if(layer < NUM_LAYERS) {
+		current_layer = layer;
+	}
+}
+
+void framebuffer_set_pixel(uint8_t x, uint8_t y, PixelColour colour) {
+	if(x >= MATRIX_TOTAL_COLUMNS || y >= MATRIX_NUM_ROWS) {
+		// Position isn't valid - we ignore the request.
+		return;
+	}
+	if(frame[x][y] != colour || GET_LAYER(x, y) != current_layer) {
+		if(frame[x][y] != colour) {
+			mark_unsent(x, 1 << y);
+		}
+		frame[x][y] = colour;
+		SET_LAYER(x, y, current_layer);
+		mark_dirty(x, y);
+	}
+}
+
+void framebuffer_set_address(uint16_t address, PixelColour colour) {
+	framebuffer_set_pixel(MATRIX_ADDRESS_X(address), MATRIX_ADDRESS_Y(address), colour);
+}
+
+// The same as framebuffer_set_pixel() for each pixel, without working 
+// out each pixel's address from scratch or a call per pixel.
+void framebuffer_set_line(uint16_t address, uint16_t step, uint8_t pixels,
+		uint8_t lit, PixelColour colour) {
+	uint8_t x, y;
+	PixelColour pixel;
+	
+	for(; pixels; pixels >>= 1, lit >>= 1, address += step) {
+		x = MATRIX_ADDRESS_X(address);
+		y = MATRIX_ADDRESS_Y(address);
+		if(!(pixels & 1) || x >= MATRIX_TOTAL_COLUMNS || y >= MATRIX_NUM_ROWS) {
+			continue;
+		}
+		pixel = (lit & 1) ? colour : COLOUR_BLACK;
+		if(frame[x][y] != pixel) {
+			mark_unsent(x, 1 << y);
+			frame[x][y] = pixel;
+		} else if(GET_LAYER(x, y) == current_layer) {
+			continue;
+		}
+		SET_LAYER(x, y, current_layer);
+		mark_dirty(x, y);
+	}
+}
+
+PixelColour framebuffer_get_pixel(uint8_t x, uint8_t y) {
+	if(x >= MATRIX_TOTAL_COLUMNS || y >= MATRIX_NUM_ROWS) {
+		return COLOUR_BLACK;
+	}
+	return frame[x][y];
+}
+
+PixelColour framebuffer_get_address(uint16_t address) {
+	return framebuffer_get_pixel(MATRIX_ADDRESS_X(address), MATRIX_ADDRESS_Y(address));
+}
+
+uint8_t framebuffer_get_address_layer(uint16_t address) {
+	uint8_t x = MATRIX_ADDRESS_X(address);
+	uint8_t y = MATRIX_ADDRESS_Y(address);
+	if(x >= MATRIX_TOTAL_COLUMNS || y >= MATRIX_NUM_ROWS) {
+		return LAYER_FIELD;
+	}
+	return GET_LAYER(x, y);
+}
+
+uint8_t framebuffer_unsent(uint8_t viewer, uint8_t x) {
+	if(x >= MATRIX_TOTAL_COLUMNS) {
+		return 0;
+	}
+	return unsent[viewer][x];
+}
+
+void framebuffer_set_unsent(uint8_t viewer, uint8_t x, uint8_t rows) {
+	if(x < MATRIX_TOTAL_COLUMNS) {
+		unsent[viewer][x] = rows;
+	}
+}
+
+void framebuffer_refresh_layer(uint8_t layer) {
+	for(uint8_t x = 0; x < MATRIX_TOTAL_COLUMNS; x++) {
+		for(uint8_t y = 0; y < MATRIX_NUM_ROWS; y++) {
+			if(frame[x][y] != COLOUR_BLACK && GET_LAYER(x, y) == layer) {
+				mark_dirty(x, y);
+			}
+		}
+	}
+}
+
+// Copy column "from" of the shadow copy to column "to".
+static void copy_column(uint8_t from, uint8_t to) {
+	for(uint8_t y = 0; y < MATRIX_NUM_ROWS; y++) {
+		frame[to][y] = frame[from][y];
+	}
+	frame_layer[to] = frame_layer[from];
+	dirty[to] = dirty[from];
+}
+
+// Make column x of the shadow copy black and send it in full on the
+// next flush.
+static void blank_column(uint8_t x) {
+	for(uint8_t y = 0; y < MATRIX_NUM_ROWS; y++) {
+		frame[x][y] = COLOUR_BLACK;
+	}
+	frame_layer[x] = 0;
+	dirty[x] = 0xFF;
+}
+
+void framebuffer_shift(uint8_t direction) {
+	uint8_t i, x, y, from, panel;
+	int8_t carry;
+
+	switch(direction) {
+		case SHIFT_LEFT:
+			for(x = 0; x < MATRIX_TOTAL_COLUMNS - 1; x++) {
+				copy_column(x + 1, x);
+			}
+			blank_column(MATRIX_TOTAL_COLUMNS - 1);
+			ledmatrix_shift_display_left();
+			break;
+		case SHIFT_RIGHT:
+			for(x = MATRIX_TOTAL_COLUMNS - 1; x > 0; x--) {
+				copy_column(x - 1, x);
+			}
+			blank_column(0);
+			ledmatrix_shift_display_right();
+			break;
+		case SHIFT_UP:
+		case SHIFT_DOWN:
+			// The row shifted in to each panel comes from the panel 
+			// carry places along the chain (see orientation.h), or is 
+			// black. Work away from that panel so that its row hasn't 
+			// been shifted out yet.
+			carry = (direction == SHIFT_UP) ? 
+					ORIENTATION_SHIFT_UP_CARRY : -ORIENTATION_SHIFT_UP_CARRY;
+			for(i = 0; i < MATRIX_TOTAL_COLUMNS; i++) {
+				x = (carry < 0) ? MATRIX_TOTAL_COLUMNS - 1 - i : i;
+				if(direction == SHIFT_UP) {
+					for(y = MATRIX_NUM_ROWS - 1; y > 0; y--) {
+						frame[x][y] = frame[x][y - 1];
+					}
+					frame_layer[x] <<= LAYER_BITS;
+					dirty[x] <<= 1;
+				} else {
+					for(y = 0; y < MATRIX_NUM_ROWS - 1; y++) {
+						frame[x][y] = frame[x][y + 1];
+					}
+					frame_layer[x] >>= LAYER_BITS;
+					dirty[x] >>= 1;
+				}
+				// y is now the row shifted in
+				from = x + carry * MATRIX_NUM_COLUMNS;
+				if(carry != 0 && from < MATRIX_TOTAL_COLUMNS) {
+					frame[x][y] = frame[from][MATRIX_NUM_ROWS - 1 - y];
+					SET_LAYER(x, y, GET_LAYER(from, MATRIX_NUM_ROWS - 1 - y));
+				} else {
+					frame[x][y] = COLOUR_BLACK;
+					SET_LAYER(x, y, LAYER_FIELD);
+				}
+			}
+			if(direction == SHIFT_UP) {
+				dirty_rows = (dirty_rows << 1) | 1;
+				ledmatrix_shift_display_up();
+			} else {
+				dirty_rows = (dirty_rows >> 1) | (1 << (MATRIX_NUM_ROWS - 1));
+				ledmatrix_shift_display_down();
+			}
+			break;
+		default:
+			return;
+	}
+	// The viewers don't shift, so they may now differ anywhere
+	for(x = 0; x < MATRIX_TOTAL_COLUMNS; x++) {
+		mark_unsent(x, 0xFF);
+	}
+	// Each panel shifts separately, so the column each one shifted in
+	// has to be sent even where the shadow copy carries on from the 
+	// next panel
+	for(panel = 0; panel < LEDMATRIX_NUM_PANELS; panel++) {
+		if(direction == SHIFT_LEFT) {
+			dirty[panel * MATRIX_NUM_COLUMNS + MATRIX_NUM_COLUMNS - 1] = 0xFF;
+		} else if(direction == SHIFT_RIGHT) {
+			dirty[panel * MATRIX_NUM_COLUMNS] = 0xFF;
+		}
+		dirty_panels |= (1 << panel);
+	}
+}
+
+// Send the dirty rows and columns of one panel. The panel must already be 
+// selected.
+static uint16_t flush_panel(uint8_t panel) {
+	uint16_t bytes_sent = 0;
+	uint8_t count, x;
+	MatrixColumn column;
+	MatrixRow row;
+
+	// Whole rows first - their pixels then don't need sending again
+	for(uint8_t y = 0; y < MATRIX_NUM_ROWS; y++) {
+		if(!(dirty_rows & (1 << y))) {
+			continue;
+		}
+		for(uint8_t col = 0; col < MATRIX_NUM_COLUMNS; col++) {
+			x = panel * MATRIX_NUM_COLUMNS + col;
+			row[col] = palette_apply(frame[x][y], GET_LAYER(x, y));
+			dirty[x] &= ~(1 << y);
+		}
+		ledmatrix_update_row(y, row);
+		bytes_sent += ROW_UPDATE_BYTES;
+	}
+
+	for(uint8_t col = 0; col < MATRIX_NUM_COLUMNS; col++) {
+		x = panel * MATRIX_NUM_COLUMNS + col;
+		if(dirty[x] == 0) {
+			continue;
+		}
+		// Count the dirty pixels in this column
+		count = 0;
+		for(uint8_t bits = dirty[x]; bits; bits &= bits - 1) {
+			count++;
+		}
+		if(count >= COLUMN_THRESHOLD) {
+			for(uint8_t y = 0; y < MATRIX_NUM_ROWS; y++) {
+				column[y] = palette_apply(frame[x][y], GET_LAYER(x, y));
+			}
+			ledmatrix_update_column(col, column);
+			bytes_sent += COLUMN_UPDATE_BYTES;
+		} else {
+			for(uint8_t y = 0; y < MATRIX_NUM_ROWS; y++) {
+				if(dirty[x] & (1 << y)) {
+					ledmatrix_update_pixel(col, y,
+							palette_apply(frame[x][y], GET_LAYER(x, y)));
+					bytes_sent += PIXEL_UPDATE_BYTES;
+				}
+			}
+		}
+		dirty[x] = 0;
+	}
+	return bytes_sent;
+}
+
+uint16_t framebuffer_flush(void) {
+	uint16_t bytes_sent = 0;
+
+	for(uint8_t panel = 0; panel < LEDMATRIX_NUM_PANELS; panel++) {
+		if(dirty_panels & (1 << panel)) {
+			ledmatrix_select_panel(panel);
+			bytes_sent += flush_panel(panel);
+		}
+	}
+	dirty_panels = 0;
+	dirty_rows = 0;
+	// Leave panel 0 selected for anything which draws directly
+	ledmatrix_select_panel(0);
+	return bytes_sent;
+}
@@ -0,0 +1,88 @@
+/*
+ * framebuffer.h
+ *
+ * Author: Matt Burton
+ *
+ * A shadow copy of the LED matrix held in RAM. Drawing is done into the
+ * shadow copy, which remembers which pixels have changed. Calling
+ * framebuffer_flush() sends only the changed pixels to the matrix - as
+ * single pixel updates when only a few pixels in a column have changed,
+ * or as one column update when that is cheaper.
+ * Coordinates are LED matrix coordinates (see ledmatrix.h) across all
+ * panels, i.e. x ranges from 0 to MATRIX_TOTAL_COLUMNS - 1. Each panel's
+ * changes are sent in one pass, and panels with no changes are skipped.
+ * Each pixel also records the layer it was drawn on. Colours are passed
+ * through the palette (see palette.h) as they are sent to the matrix.
+ */
+
+#ifndef FRAMEBUFFER_H_
+#define FRAMEBUFFER_H_
+
+#include <stdint.h>
+#include "pixel_colour.h"
+
+// Clear the shadow copy and the LED matrix itself. Nothing is left dirty.
+void framebuffer_clear(void);
+
+// Choose the layer that subsequent framebuffer_set_pixel() calls draw on.
+// The layer is LAYER_FIELD after framebuffer_clear().
+void framebuffer_select_layer(uint8_t layer);
+
+// Set/get a pixel in the shadow copy. Setting a pixel to the colour it
+// already has does not mark it as dirty. Invalid positions are ignored
+// (get returns COLOUR_BLACK).
+void framebuffer_set_pixel(uint8_t x, uint8_t y, PixelColour colour);
+PixelColour framebuffer_get_pixel(uint8_t x, uint8_t y);
+
+// Set a pixel given its matrix address (see MATRIX_ADDRESS in 
+// orientation.h).
+void framebuffer_set_address(uint16_t address, PixelColour colour);
+
+// Set a line of up to 8 pixels in one go: bit i of pixels is the pixel
+// at address + i * step (step is added as a uint16_t, so moving back one
+// pixel is (uint16_t)-1). The pixels whose bit of lit is set are set to
+// colour, and the rest to black. Pixels at invalid addresses are ignored.
+void framebuffer_set_line(uint16_t address, uint16_t step, uint8_t pixels,
+		uint8_t lit, PixelColour colour);
+
+// Get the colour of a pixel, or the layer it was drawn on, given its
+// matrix address. Invalid addresses give COLOUR_BLACK and LAYER_FIELD.
+PixelColour framebuffer_get_address(uint16_t address);
+uint8_t framebuffer_get_address_layer(uint16_t address);
+
+// Each of the framebuffer's viewers - the display stream (see 
+// framestream.h) and the terminal view (see termview.h) - has a bit per
+// pixel which set_pixel() sets when the pixel changes colour. The viewer
+// clears it with framebuffer_set_unsent() once it has sent the pixel, so
+// this is all a viewer needs to remember rather than a copy of what it
+// sent. Bit y of framebuffer_unsent(viewer, x) is pixel (x,y)'s bit.
+// Shifting or clearing sets every bit. Invalid columns read as 0.
+#define VIEWER_STREAM	0
+#define VIEWER_TERMINAL	1
+#define NUM_VIEWERS		2
+uint8_t framebuffer_unsent(uint8_t viewer, uint8_t x);
+void framebuffer_set_unsent(uint8_t viewer, uint8_t x, uint8_t rows);
+
+// Mark every lit pixel on the given layer as dirty (e.g. because the
+// brightness of that layer has changed).
+void framebuffer_refresh_layer(uint8_t layer);
+
+// Shift the whole display one pixel in the given direction (SHIFT_LEFT
+// moves everything towards x = 0, SHIFT_UP towards y = 7) with the LED
+// matrix's own shift command, and the shadow copy to match. The row or
+// column shifted in is black and is sent in full on the next flush (as
+// is each panel's incoming edge column for a left/right shift, since 
+// each panel shifts on its own). When the panels are turned (see 
+// ORIENTATION_SHIFT_UP_CARRY in orientation.h) an up/down shift carries
+// each panel's outgoing row on to the next panel instead of blanking it.
+#define SHIFT_LEFT	0
+#define SHIFT_RIGHT	1
+#define SHIFT_UP	2
+#define SHIFT_DOWN	3
+void framebuffer_shift(uint8_t direction);
+
+// Send all dirty pixels to the LED matrix. Returns the number of
+// SPI bytes sent (0 if nothing had changed).
+uint16_t framebuffer_flush(void);
+
+#endif /* FRAMEBUFFER_H_ */
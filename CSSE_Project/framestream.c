@@ -0,0 +1,167 @@
+/*
+ * framestream.c
+ *
+ * Written by Matt Burton
+ */
+
+#include "framestream.h"
+#include "framebuffer.h"
+#include "ledmatrix.h"
+#include "telemetry.h"
+
+#define HEADER_BYTES	4
+#define NUM_PIXELS		(MATRIX_TOTAL_COLUMNS * MATRIX_NUM_ROWS)
+
+// Move on to the next pixel in stream order. changes holds the current
+// column's unsent bits (see framebuffer.h), and is written back when
+// we move on to the next column.
+#define NEXT_PIXEL()	do {										\
+			p++;													\
+			if(++y == MATRIX_NUM_ROWS) {							\
+				framebuffer_set_unsent(VIEWER_STREAM, x, changes);	\
+				y = 0;												\
+				x++;												\
+				changes = framebuffer_unsent(VIEWER_STREAM, x);		\
+			}														\
+		} while(0)
+
+static uint8_t enabled;
+static uint32_t next_frame_time;
+static uint8_t frame_number;
+static uint8_t frames_to_keyframe;
+
+static uint8_t frame_bytes;
+static uint32_t total_bytes;
+static uint16_t deferred_frames;
+
+static uint8_t add_changes(uint8_t* packet, uint8_t length, uint8_t limit);
+
+void framestream_enable(uint8_t enable) {
+	enabled = enable;
+	frames_to_keyframe = 0;
+	frame_bytes = 0;
+	total_bytes = 0;
+	deferred_frames = 0;
+}
+
+uint8_t framestream_enabled(void) {
+	return enabled;
+}
+
+void framestream_update(uint32_t current_time) {
+	uint8_t packet[HEADER_BYTES + FRAMESTREAM_MAX_BYTES];
+	uint8_t limit = telemetry_space();
+	uint8_t length;
+	
+	if(!enabled || current_time < next_frame_time) {
+		return;
+	}
+	next_frame_time = current_time + FRAMESTREAM_FRAME_MS;
+	frame_bytes = 0;
+	
+	// Leave room for log records
+	if(limit < FRAMESTREAM_RESERVE + HEADER_BYTES + 3) {
+		deferred_frames++;
+		return;
+	}
+	limit -= FRAMESTREAM_RESERVE;
+	if(limit > sizeof(packet)) {
+		limit = sizeof(packet);
+	}
+	
+	if(frames_to_keyframe == 0) {
+		// The viewer clears its display, so we send everything that 
+		// isn't black (and nothing that is)
+		for(uint8_t x = 0; x < MATRIX_TOTAL_COLUMNS; x++) {
+			uint8_t lit = 0;
+			for(uint8_t y = 0; y < MATRIX_NUM_ROWS; y++) {
+				if(framebuffer_get_pixel(x, y) != COLOUR_BLACK) {
+					lit |= (1 << y);
+				}
+			}
+			framebuffer_set_unsent(VIEWER_STREAM, x, lit);
+		}
+		packet[1] = 'K';
+		frames_to_keyframe = FRAMESTREAM_KEYFRAME_FRAMES;
+	} else {
+		packet[1] = 'D';
+	}
+	frames_to_keyframe--;
+	
+	length = add_changes(packet, HEADER_BYTES, limit);
+	if(length == HEADER_BYTES && packet[1] == 'D') {
+		// Nothing has changed
+		return;
+	}
+	packet[0] = FRAMESTREAM_MARKER;
+	packet[2] = frame_number++;
+	packet[3] = length - HEADER_BYTES;
+	(void)telemetry_write(packet, length);
+	frame_bytes = length;
+	total_bytes += length;
+}
+
+uint8_t framestream_frame_bytes(void) {
+	return frame_bytes;
+}
+
+uint32_t framestream_total_bytes(void) {
+	return total_bytes;
+}
+
+uint16_t framestream_deferred_frames(void) {
+	return deferred_frames;
+}
+
+// Add runs for the changed pixels to the packet, which has "length"
+// bytes in it so far, until it has "limit" bytes. The pixels sent are
+// marked as streamed in the framebuffer. Returns the new length of the
+// packet.
+static uint8_t add_changes(uint8_t* packet, uint8_t length, uint8_t limit) {
+	uint16_t p = 0;
+	uint8_t x = 0;
+	uint8_t y = 0;
+	uint16_t skip = 0;
+	uint8_t changes = framebuffer_unsent(VIEWER_STREAM, 0);
+	uint8_t count, count_index, empty_runs;
+	PixelColour colour;
+	
+	while(p < NUM_PIXELS) {
+		if(!(changes & (1 << y))) {
+			skip++;
+			NEXT_PIXEL();
+			continue;
+		}
+		
+		// A run of changed pixels, all set to the same colour - after 
+		// empty runs if there are too many pixels to skip in one go
+		empty_runs = (skip > 255) ? (skip - 1) / 255 : 0;
+		if(length + 2 * empty_runs + 3 > limit) {
+			break;
+		}
+		while(empty_runs--) {
+			packet[length++] = 255;
+			packet[length++] = 0;
+			skip -= 255;
+		}
+		colour = framebuffer_get_pixel(x, y);
+		packet[length++] = skip;
+		count_index = length++;
+		packet[length++] = colour;
+		count = 0;
+		skip = 0;
+		do {
+			changes &= ~(1 << y);
+			count++;
+			NEXT_PIXEL();
+		} while(p < NUM_PIXELS && count < 255 && (changes & (1 << y)) &&
+				framebuffer_get_pixel(x, y) == colour);
+		packet[count_index] = count;
+	}
+	if(p < NUM_PIXELS) {
+		// Out of room part way through a column
+		framebuffer_set_unsent(VIEWER_STREAM, x, changes);
+		deferred_frames++;
+	}
+	return length;
+}
@@ -0,0 +1,55 @@
+/*
+ * framestream.h
+ *
+ * Author: Matt Burton
+ *
+ * Streams the LED matrix contents over the telemetry port (see
+ * telemetry.h) so a viewer on
+ * the host can show what the board is displaying. Each frame only the 
+ * pixels that have changed since the last frame are sent, as runs of
+ * one colour, and every FRAMESTREAM_KEYFRAME_FRAMES frames the whole
+ * display is sent again (so a viewer can start at any time).
+ *
+ * Frames are sent at most every FRAMESTREAM_FRAME_MS, and each is 
+ * limited to FRAMESTREAM_MAX_BYTES - and to the free space in the serial
+ * output buffer less FRAMESTREAM_RESERVE, which is left for log 
+ * records. Changes that don't fit are sent with the next frame (the 
+ * stream is always relative to what was last sent, not to the last 
+ * frame).
+ *
+ * Each frame is sent as a packet in among the log records:
+ *	FRAMESTREAM_MARKER, type, frame number, payload length, payload
+ * The type is 'K' for a keyframe (the viewer clears the display first)
+ * or 'D'. The payload is a list of runs, each
+ *	skip, count, colour
+ * meaning: leave the next "skip" pixels as they are, then set the next
+ * "count" pixels to "colour" (omitted if count is 0). Pixels are in 
+ * matrix column order - (0,0), (0,1), ... (0,7), (1,0), ... - across all
+ * panels (see ledmatrix.h) and colours are as in pixel_colour.h.
+ */
+
+#ifndef FRAMESTREAM_H_
+#define FRAMESTREAM_H_
+
+#include <stdint.h>
+
+#define FRAMESTREAM_MARKER			0x1E
+#define FRAMESTREAM_FRAME_MS		100
+#define FRAMESTREAM_KEYFRAME_FRAMES	50
+#define FRAMESTREAM_MAX_BYTES		48
+#define FRAMESTREAM_RESERVE			16
+
+void framestream_enable(uint8_t enable);
+uint8_t framestream_enabled(void);
+
+// Send a frame if it's time to. Call after framebuffer_flush().
+void framestream_update(uint32_t current_time);
+
+// The number of bytes sent for the last frame (including the packet
+// header), the total sent since the stream was enabled, and the number
+// of frames which couldn't send all their changes.
+uint8_t framestream_frame_bytes(void);
+uint32_t framestream_total_bytes(void);
+uint16_t framestream_deferred_frames(void);
+
+#endif /* FRAMESTREAM_H_ */
@@ -9,21 +9,23 @@
 #include "scrolling_char_display.h"
 #include "timer0.h"
 #include "terminalio.h"
-#include "serialio.h"
 #include "buttons.h"
 #include "lives.h"
 #include "score.h"
 #include "game.h"
 #include "sound.h"
 #include "ledmatrix.h"
+#include "framebuffer.h"
+#include "sprite.h"
+#include "palette.h"
+#include "particles.h"
+#include "entity.h"
+#include "spatial.h"
 #include "pixel_colour.h"
 #include <stdlib.h>
 /* Stdlib needed for random() - random number generator */
-#include <stdio.h>
 #include <avr/pgmspace.h>
-/* Needed for printf_P and PSTR functions. 
-Potential to handle this in project.c by waiting for a score update. 
-However, this carries performance cost. This way uses more memory.*/
+/* Needed for PROGMEM tables. */
 
 ///////////////////////////////////////////////////////////
 // Colours
@@ -32,32 +34,61 @@ However, this carries performance cost. This way uses more memory.*/
 #define COLOUR_BASE			COLOUR_YELLOW
 
 ///////////////////////////////////////////////////////////
-// Game positions (x,y) where x is 0 to 7 and y is 0 to 15
-// are represented in a single 8 bit unsigned integer where the most
-// significant 4 bits are the x value and the least significant 4 bits
-// are the y value. The following macros allow the extraction of x and y
-// values from a combined position value and the construction of a combined 
-// position value from separate x, y values. Values are assumed to be in
-// valid ranges. Invalid positions are any where the least significant
-// bit is 1 (i.e. x value greater than 7). We can use all 1's (255) to 
-// represent this.
-#define GAME_POSITION(x,y)		( ((x) << 4)|((y) & 0x0F) )
-#define GET_X_POSITION(posn)	((posn) >> 4)
-#define GET_Y_POSITION(posn)	((posn) & 0x0F)
-#define INVALID_POSITION		255
+// The base station shape. BASE_SPRITE may be any sprite up to BASE_ROWS
+// high - column BASE_CENTRE of the sprite is drawn at basePosition.
+// Projectiles are fired from the row above the base.
+#define BASE_SPRITE			sprite_base
+#define BASE_ROWS			2
+#define BASE_CENTRE			1
+#define PROJECTILE_START_ROW	BASE_ROWS
 
 ///////////////////////////////////////////////////////////
-// Macros to convert game position to LED matrix position
-// Note that the row number (y value) in the game (0 to 15 from the bottom) 
-// corresponds to x values on the LED matrix (0 to 15).
-// Column numbers (x values) in the game (0 to 7 from the left) correspond
-// to LED matrix y values rom 7 to 0
-//
-// Note that these macros result in two expressions that are comma separated - suitable
-// as use for the first two arguments to ledmatrix_update_pixel().
-#define LED_MATRIX_POSN_FROM_XY(gameX, gameY)		(gameY) , (7-(gameX))
-#define LED_MATRIX_POSN_FROM_GAME_POSN(posn)		\
-		LED_MATRIX_POSN_FROM_XY(GET_X_POSITION(posn), GET_Y_POSITION(posn))
+// Asteroid shapes (index into sprite_asteroid[] - see sprite.c)
+#define ASTEROID_SINGLE		0	// 1 x 1
+#define ASTEROID_PAIR		1	// 2 x 1
+#define ASTEROID_BLOCK		2	// 2 x 2
+#define ASTEROID_ELL		3	// L shape, 2 x 2 less the top right
+#define ASTEROID_MAX_WIDTH	2	// The widest of the shapes above
+
+// Asteroids in the spatial index buckets (see spatial.h) more than 
+// FAR_MARGIN columns from the display are only moved every FAR_TICKS 
+// ticks (by FAR_TICKS ticks' worth).
+#define FAR_TICKS	4
+#define FAR_MARGIN	VIEW_WIDTH
+
+// Number of random positions we try when placing a new asteroid before
+// giving up (the field may be too crowded for the chosen shape).
+#define PLACEMENT_ATTEMPTS	16
+
+// New asteroids are mostly single cells - this table is indexed by a
+// random number from 0 to 7.
+static const uint8_t random_shape_table[8] PROGMEM = {
+	ASTEROID_SINGLE, ASTEROID_SINGLE, ASTEROID_SINGLE, ASTEROID_SINGLE,
+	ASTEROID_SINGLE, ASTEROID_PAIR, ASTEROID_BLOCK, ASTEROID_ELL
+};
+
+// When an asteroid is hit it breaks into up to two smaller ones either
+// side of it, in the same row. Offsets are from the x position of the
+// asteroid that was hit. A shape of ASTEROID_NONE means no fragment.
+#define ASTEROID_NONE		0xFF
+typedef struct {
+	uint8_t shape[2];
+	int8_t offset[2];
+} AsteroidSplit;
+
+static const AsteroidSplit asteroid_splits[NUM_ASTEROID_SHAPES] PROGMEM = {
+	{{ASTEROID_NONE, ASTEROID_NONE}, {0, 0}},		// single
+	{{ASTEROID_SINGLE, ASTEROID_SINGLE}, {-1, 2}},	// pair
+	{{ASTEROID_PAIR, ASTEROID_PAIR}, {-2, 2}},		// block
+	{{ASTEROID_SINGLE, ASTEROID_PAIR}, {-1, 2}}		// L
+};
+
+// An asteroid which has been shot, waiting to be broken up and scored.
+typedef struct {
+	GamePosition position;
+	uint8_t shape;
+	uint16_t velocity;
+} AsteroidHit;
 
 ///////////////////////////////////////////////////////////
 // Global variables.
@@ -65,90 +96,199 @@ However, this carries performance cost. This way uses more memory.*/
 // basePosition - stores the x position of the centre point of the 
 // base station. The base station is three positions wide, but is
 // permitted to partially move off the game field so that the centre
-// point can take on any position from 0 to 7 inclusive.
+// point can take on any position from 0 to FIELD_WIDTH-1 inclusive.
+//
+// Asteroids and projectiles are entities (see entity.h). For an
+// asteroid the entity position is the bottom left corner of its shape
+// and the entity variant is the shape (ASTEROID_SINGLE etc.). The
+// entity velocity is how far the asteroid falls per tick (in cells, 8.8
+// fixed point, i.e. 256 is one cell per tick - see ASTEROID_VELOCITY in
+// game.h), and the entity fraction is the fractional part of its y
+// position, which together with the y value of the position makes an
+// 8.8 fixed point position. The fraction counts down from the top of
+// the cell, so the asteroid moves down a cell each time the velocity
+// carries out of it. Projectiles only use the position.
 //
 // numProjectiles - The number of projectiles currently in flight. Must
 // be less than or equal to MAX_PROJECTILES.
 //
-// projectiles - x,y positions of the projectiles that are currently
-// in flight. The upper 4 bits represent the x position; the lower 4
-// bits represent the y position. The array is indexed by projectile
-// number from 0 to numProjectiles - 1.
-//
 // numAsteroids - The number of asteroids currently on the game field.
 // Must be less than or equal to MAX_ASTEROIDS.
 //
-// asteroids - x,y positions of the asteroids on the field. The upper
-// 4 bits represent the x position; the lower 4 bits represent the 
-// y position. The array is indexed by asteroid number from 0 to 
-// numAsteroids - 1.
+// asteroid_rows, projectile_rows - which cells of each row of the field
+// are covered by an asteroid/projectile (see FieldRow in game.h). Objects
+// of the same kind never overlap, so these are kept up to date by setting
+// and clearing an object's cells whenever it is added, moved or removed.
+// Collisions are then found by AND-ing an object's shape, shifted to its
+// position, against these rows - one operation per row the object spans.
+// asteroid_rows points to one of asteroid_row_buffers - it is double 
+// buffered along with the entity positions (see advance_asteroids()).
+//
+// base_rows - the cells covered by the base station (rows 0 to 
+// BASE_ROWS - 1), i.e. the base sprite's mask shifted to basePosition.
+//
+// The update functions (move_base(), fire_projectile(), advance_...())
+// don't destroy or create anything while they work through the
+// entities. Instead the following queues are filled in, and then applied
+// in one pass at the end by apply_queues():
+// removalQueue - handles of the entities which have been taken off the
+// field. They have already been erased and cleared from the occupancy
+// rows, and are flagged ENTITY_FLAG_GONE, but are still in the pool.
+// hitQueue - the asteroids which were shot (where they were, their
+// shape and velocity). Each collision uses up a projectile so there
+// can't be more than MAX_PROJECTILES per update.
+// baseHits - the number of times the base was hit.
+// pendingAsteroids - the number of new asteroids to add at the top of
+// the field, including those that could not be added before because
+// there was no room.
+//
+// tickCollisions - collisions applied since the last asteroid or 
+// projectile tick. lastTickCollisions - the number in the last tick 
+// (see get_tick_collisions() in game.h).
+//
+// speedScale - multiplier applied to every asteroid's velocity (8.8 
+// fixed point) - see set_asteroid_speed_scale() in game.h.
+//
+// nearFirstBucket, nearLastBucket - the spatial index buckets which are
+// moved every tick (the ones in view or within FAR_MARGIN of it). These
+// are only updated every FAR_TICKS ticks, when the others are moved, so
+// that every asteroid is moved by the right amount. farTickCount counts
+// the ticks up to FAR_TICKS.
+//
+// tickNumber - the number of asteroid ticks since the game started.
 
 int8_t		basePosition;
 int8_t		numProjectiles;
-uint8_t		projectiles[MAX_PROJECTILES];
 int8_t		numAsteroids;
-uint8_t		asteroids[MAX_ASTEROIDS];
-uint8_t		asteroid_speeds[MAX_ASTEROIDS];
+FieldRow	asteroid_row_buffers[2][FIELD_HEIGHT];
+FieldRow*	asteroid_rows = asteroid_row_buffers[0];
+FieldRow	projectile_rows[FIELD_HEIGHT];
+FieldRow	base_rows[BASE_ROWS];
+EntityHandle	removalQueue[MAX_ENTITIES];
+uint8_t		numRemovals;
+AsteroidHit	hitQueue[MAX_PROJECTILES];
+uint8_t		numHits;
+uint8_t		baseHits;
+uint8_t		pendingAsteroids;
+uint8_t		tickCollisions;
+uint8_t		lastTickCollisions;
+uint16_t	speedScale = ASTEROID_SPEED_SCALE_NORMAL;
+uint8_t		nearFirstBucket;
+uint8_t		nearLastBucket;
+uint8_t		farTickCount;
+uint16_t	tickNumber;
 
 ///////////////////////////////////////////////////////////
 // Prototypes for internal information functions 
 //  - not available outside this module.
 
-// Is there is an asteroid/projectile/base at the given position?. 
-// Returns -1 if no, asteroid/projectile index number if yes.
-// base_at returns boolean values, 1 for yes, 0 for no.
-static int8_t base_at(uint8_t x, uint8_t y);
+// Move every asteroid that still has cells to cross down one cell, all
+// at the same time. Returns 1 if any asteroid has further to go.
+static uint8_t step_asteroids(uint8_t* cells);
+// Destroy the removed entities, then deal with the collisions and add
+// new asteroids (see removalQueue etc. above).
+static void apply_queues(void);
+static uint16_t random_velocity(void);
+
+// Is there is an asteroid/projectile at the given position?. 
+// Returns -1 if no, the entity slot number of the asteroid/projectile
+// if yes.
 static int8_t asteroid_at(uint8_t x, uint8_t y);
 static int8_t projectile_at(uint8_t x, uint8_t y);
 
-// Remove the asteroid/projectile at the given index number. If
-// the index is not valid, then no removal is performed. 
-static void remove_asteroid(int8_t asteroidIndex);
-static void remove_projectile(int8_t projectileIndex);
+// Shape masks and occupancy rows
+static FieldRow shift_row(uint8_t bits, int8_t x);
+static FieldRow asteroid_row_mask(uint8_t shape, uint8_t row, uint8_t x);
+static int8_t shape_overlap(uint8_t shape, uint8_t x, uint8_t y,
+		const FieldRow* rows, uint8_t numRows, FieldRow* overlap);
+static void mark_shape(FieldRow* rows, uint8_t shape, uint8_t x, uint8_t y, 
+		uint8_t occupied);
+static void mark_asteroid(uint8_t asteroid, uint8_t occupied);
+static void update_base_rows(void);
+static void update_near_buckets(void);
+static uint8_t remove_asteroids_on_base(void);
+static uint8_t lowest_bit(FieldRow bits);
+
+// Take the asteroid/projectile in the given entity slot off the field
+// and queue it to be destroyed. If the slot is -1, or the entity has
+// already been removed, then no removal is performed. 
+static void remove_entity(int8_t slot);
 // Handle the collision between an asteroid and a projectile.
-static void handle_collision(int8_t asteroidIndex, int8_t projectileIndex);
+static void handle_collision(int8_t asteroid, int8_t projectile);
+// Break up/replace an asteroid which has been shot, and score it.
+static void asteroid_destroyed(uint8_t x, uint8_t y, uint8_t shape, 
+		uint16_t velocity);
 // Add an asteroid into the environment, somewhere in top two rows.
 static void add_asteroid();
+// Place an asteroid of the given shape at (x,y) if that space is free.
+// Returns the new asteroid's slot, or -1 if it wasn't added.
+static int8_t place_asteroid(uint8_t shape, int8_t x, uint8_t y, uint16_t velocity);
+// Break a hit asteroid into smaller pieces. Returns the number added.
+static uint8_t split_asteroid(uint8_t shape, uint8_t x, uint8_t y, uint16_t velocity);
+static uint8_t random_shape(void);
 
 // Redraw functions
 static void redraw_whole_display(void);
 static void redraw_base(uint8_t colour);
 static void redraw_hit_base(void);
 static void redraw_all_asteroids(void);
-static void redraw_asteroid(uint8_t asteroidNumber, uint8_t colour);
+static void redraw_asteroid(uint8_t asteroid, uint8_t colour);
 static void redraw_all_projectiles(void);
-static void redraw_projectile(uint8_t projectileNumber, uint8_t colour);
+static void redraw_projectile(uint8_t projectile, uint8_t colour);
+static void redraw_column(uint8_t x);
+static uint8_t first_visible_bucket(void);
+static uint8_t last_visible_bucket(void);
 ///////////////////////////////////////////////////////////
 
  
 // Initialise game field:
-// (1) base starts in the centre (x=3)
+// (1) base starts in the centre (just left of it on an even width field)
 // (2) no projectiles initially
 // (3) the maximum number of asteroids, randomly distributed.
 void initialise_game(void) {
-	uint8_t x, y, i;
+	uint8_t x, y, i, shape, attempt;
 	
-    basePosition = 3;
+    basePosition = FIELD_WIDTH / 2 - 1;
+	viewport_centre(basePosition);
+	entity_pool_clear();
+	spatial_clear();
 	numProjectiles = 0;
 	numAsteroids = 0;
+	numRemovals = 0;
+	numHits = 0;
+	baseHits = 0;
+	pendingAsteroids = 0;
+	tickCollisions = 0;
+	lastTickCollisions = 0;
+	speedScale = ASTEROID_SPEED_SCALE_NORMAL;
+	farTickCount = 0;
+	tickNumber = 0;
+	update_near_buckets();
+	for(y = 0; y < FIELD_HEIGHT; y++) {
+		asteroid_rows[y] = 0;
+		projectile_rows[y] = 0;
+	}
+	update_base_rows();
+	init_particles();
 
 	for(i=0; i < MAX_ASTEROIDS ; i++) {
-		// Generate random position that does not already
-		// have an asteroid.
-		do {
-			// Generate random x position - somewhere from 0
-			// to FIELD_WIDTH - 1
-			x = (uint8_t)(random() % FIELD_WIDTH);
+		// Generate random positions until we find one where the
+		// asteroid fits without overlapping an existing asteroid.
+		shape = random_shape();
+		for(attempt = 0; attempt < PLACEMENT_ATTEMPTS; attempt++) {
+			// Generate random x position - somewhere from 0 to
+			// FIELD_WIDTH - width so the whole shape is on the field
+			x = (uint8_t)(random() % (FIELD_WIDTH + 1 -
+					sprite_width(&sprite_asteroid[shape])));
 			// Generate random y position - somewhere from 3
-			// to FIELD_HEIGHT - 1 (i.e., not in the lowest
+			// to FIELD_HEIGHT - height (i.e., not in the lowest
 			// three rows)
-			y = (uint8_t)(3 + (random() % (FIELD_HEIGHT-3)));
-		} while(asteroid_at(x,y) != -1);
-		// If we get here, we've now found an x,y location without
-		// an existing asteroid - record the position
-		asteroids[i] = GAME_POSITION(x,y);
-		asteroid_speeds[i] = random() % 4;
-		numAsteroids++;
+			y = (uint8_t)(3 + (random() % (FIELD_HEIGHT - 2 -
+					sprite_height(&sprite_asteroid[shape]))));
+			if(place_asteroid(shape, x, y, random_velocity()) != -1) {
+				break;
+			}
+		}
 	}
 	
 	redraw_whole_display();
@@ -161,6 +301,8 @@ void initialise_game(void) {
 // left if basePosition is already 0.
 // Returns 1 if move successful, 0 otherwise.
 int8_t move_base(int8_t direction) {	
+	int8_t column;
+	
 	// The initial version of this function just moves
 	// the base one position to the left, no matter where
 	// the base station is now or what the direction argument
@@ -176,28 +318,31 @@ int8_t move_base(int8_t direction) {
 		// Check if the user wants to move left
 		// Check bounds -> move left.
 		basePosition--;
-	} else if (direction == MOVE_RIGHT && basePosition != 7){
+	} else if (direction == MOVE_RIGHT && basePosition != FIELD_WIDTH - 1){
 		// Assume right press, check bounds -> move right.
 		basePosition++;
 	} else {
 		redraw_base(COLOUR_BASE);
 		return 0;
 	}
+	update_base_rows();
 	
+	// Scroll the display if the base is getting close to the side
+	column = viewport_follow(basePosition);
+	if(column != -1) {
+		redraw_column(column);
+	}
 	
-	// Check if the base is being moved into an asteroid. 
-	// We don't need to check the middle as it is impossible to reach.
-	if (asteroid_at(basePosition, 1) != -1 ||  asteroid_at(basePosition - 1, 0) != -1 
-	|| asteroid_at(basePosition + 1, 0) != -1) {
-		subtract_life();
-		remove_asteroid(asteroid_at(basePosition, 1));
-		remove_asteroid(asteroid_at(basePosition - 1, 0));
-		remove_asteroid(asteroid_at(basePosition + 1, 0));
-		redraw_hit_base();
+	// Check if the base has been moved into any asteroids - one AND per
+	// row of the base against the asteroid occupancy rows. (However many
+	// asteroids it hits, it only costs one life.)
+	if (remove_asteroids_on_base()) {
+		baseHits++;
 	}
 	
 	// Redraw the base
 	redraw_base(COLOUR_BASE);
+	apply_queues();
 	
 	return 1;
 }
@@ -210,21 +355,29 @@ int8_t move_base(int8_t direction) {
 // we can have in flight (to MAX_PROJECTILES).
 // Returns 1 if projectile fired, 0 otherwise.
 int8_t fire_projectile(void) {
-	uint8_t newProjectileNumber;
-	uint8_t asteroidLocation;
+	EntityHandle newProjectile;
+	int8_t asteroidLocation;
 	
 	if(numProjectiles < MAX_PROJECTILES && 
-			projectile_at(basePosition, 2) == -1) {
+			projectile_at(basePosition, PROJECTILE_START_ROW) == -1) {
+		newProjectile = entity_create(ENTITY_PROJECTILE);
+		if(newProjectile == INVALID_ENTITY) {
+			return 0;
+		}
 		// Have space to add projectile - add it at the x position of
-		// the base, in row 2(y=2)
-		newProjectileNumber = numProjectiles++;
-		projectiles[newProjectileNumber] = GAME_POSITION(basePosition, 2);
-		asteroidLocation = asteroid_at(basePosition, 2);
+		// the base, in the row above the base
+		numProjectiles++;
+		entity_position[ENTITY_SLOT(newProjectile)] = 
+				GAME_POSITION(basePosition, PROJECTILE_START_ROW);
+		spatial_insert(ENTITY_SLOT(newProjectile));
+		projectile_rows[PROJECTILE_START_ROW] |= FIELD_BIT(basePosition);
+		asteroidLocation = asteroid_at(basePosition, PROJECTILE_START_ROW);
 		// Check if the projectile immediately hits an asteroid.
-		if (asteroid_at(basePosition, 2) != -1) {
-			handle_collision(asteroidLocation, newProjectileNumber);
+		if (asteroidLocation != -1) {
+			handle_collision(asteroidLocation, ENTITY_SLOT(newProjectile));
+			apply_queues();
 		} else {
-			redraw_projectile(newProjectileNumber, COLOUR_PROJECTILE);
+			redraw_projectile(ENTITY_SLOT(newProjectile), COLOUR_PROJECTILE);
 		}
 		return 1;
 	} else {
@@ -233,67 +386,83 @@ int8_t fire_projectile(void) {
 }
 
 
-// Move asteroids down by one position, and remove those that
-// have gone off the bottom or that hit a projectile.
+// Move the asteroids down according to their velocities, and remove
+// those that have gone off the bottom or that hit a projectile.
+// All of the asteroids move at once - each step reads the positions from
+// before the step and writes the new positions to a second buffer (see
+// step_asteroids()), so the outcome doesn't depend on the order of the 
+// asteroids in the pool. Asteroids which leave the field or hit 
+// something are queued for removal, and only destroyed once every step
+// is finished.
 void advance_asteroids(void) {
-	static uint8_t speed_number = 0;
-	uint8_t x, y;
-	int8_t asteroidNumber;
-	int8_t projectile_location;
+	// Indexed by entity slot
+	uint8_t cells[MAX_ENTITIES];
+	uint8_t slot, bucket, ticks, farTick;
+	uint32_t step;
+	uint8_t moving = 0;
 	
-	speed_number = (speed_number + 1) % 4;
-	asteroidNumber = 0;
-	while(asteroidNumber < numAsteroids) {
-		if ((speed_number + asteroid_speeds[asteroidNumber]) < 3) {
-			asteroidNumber++;
+	tickNumber++;
+	for(uint8_t i = 0; i < num_entities; i++) {
+		cells[entity_live[i]] = 0;
+	}
+	
+	// The asteroids far from the display only move every FAR_TICKS ticks
+	farTick = (++farTickCount == FAR_TICKS);
+	if(farTick) {
+		farTickCount = 0;
+	}
+	for(bucket = 0; bucket < SPATIAL_NUM_BUCKETS; bucket++) {
+		if(bucket >= nearFirstBucket && bucket <= nearLastBucket) {
+			ticks = 1;
+		} else if(farTick) {
+			ticks = FAR_TICKS;
+		} else {
 			continue;
 		}
-		// Get the current position of the asteroid
-		x = GET_X_POSITION(asteroids[asteroidNumber]);
-		y = GET_Y_POSITION(asteroids[asteroidNumber]);
-			
-		// Work out the new position (but don't update the asteroid
-		// location yet - we only do that if we know the move is valid)
-		y = y - 1;
-		projectile_location = asteroid_at(x, y);
-		if (projectile_location != -1) {
-			asteroid_speeds[asteroidNumber] = asteroid_speeds[projectile_location];
-			y = y + 1;
-		}
-			
-		// Check if new position would be off the bottom of the display
-		if(y == -1) {
-			// Yes - remove the asteroid. Add a new one in the top row.
-			remove_asteroid(asteroidNumber);
-			add_asteroid();
-		} else {
-			// Asteroid is not going off the bottom of the display
-			// CHECK HERE IF THE NEW PROJECTILE LOCATION CORRESPONDS TO
-			// AN ASTEROID LOCATION. IF IT DOES, REMOVE THE PROJECTILE
-			// AND THE ASTEROID.
-			projectile_location = projectile_at(x, y);
-			if (projectile_location != -1) {
-				handle_collision(asteroidNumber, projectile_location);
-			} else if (base_at(x, y)) {
-				// If the asteroid collides with the base, handle the event.
-				subtract_life();
-				remove_asteroid(asteroidNumber);
-				redraw_hit_base();
-			} else {
-				// Remove the asteroid from the display
-				redraw_asteroid(asteroidNumber, COLOUR_BLACK);
-					
-				// Update the asteroid's position
-				asteroids[asteroidNumber] = GAME_POSITION(x,y);
-					
-				// Redraw the asteroid
-				redraw_asteroid(asteroidNumber, COLOUR_ASTEROID);
-					
-				// Move on to the next asteroid
-				asteroidNumber++;
+		for(slot = spatial_first(bucket); slot != SPATIAL_END; slot = spatial_next[slot]) {
+			if(entity_type[slot] != ENTITY_ASTEROID) {
+				continue;
 			}
+			// Add this tick's movement to the fractional part of the 
+			// asteroid's y position. Whatever carries out of the fraction 
+			// is the number of cells the asteroid crosses this tick.
+			step = entity_fraction[slot] + 
+					(((uint32_t)entity_velocity[slot] * speedScale * ticks) >> 8);
+			entity_fraction[slot] = (uint8_t)step;
+			cells[slot] = (step >> 8) > FIELD_HEIGHT ? FIELD_HEIGHT : (uint8_t)(step >> 8);
+			moving |= cells[slot];
 		}
 	}
+	
+	// Move one cell at a time so nothing is passed through
+	while(moving) {
+		moving = step_asteroids(cells);
+	}
+	apply_queues();
+	if(farTick) {
+		update_near_buckets();
+	}
+	lastTickCollisions = tickCollisions;
+	tickCollisions = 0;
+}
+
+
+// Number of collisions in the last tick - see game.h
+uint8_t get_tick_collisions(void) {
+	return lastTickCollisions;
+}
+
+
+// Set the multiplier applied to every asteroid's velocity - see game.h
+void set_asteroid_speed_scale(uint16_t scale) {
+	if(scale > ASTEROID_SPEED_SCALE_MAX) {
+		scale = ASTEROID_SPEED_SCALE_MAX;
+	}
+	speedScale = scale;
+}
+
+uint16_t get_asteroid_speed_scale(void) {
+	return speedScale;
 }
 
 
@@ -301,14 +470,34 @@ void advance_asteroids(void) {
 // have gone off the top or that hit an asteroid.
 void advance_projectiles(void) {
 	uint8_t x, y;
-	int8_t projectileNumber;
+	uint8_t projectile;
 	int8_t asteroid_location;
+	uint8_t order[MAX_PROJECTILES];
+	uint8_t count = 0;
+	uint8_t i, j;
 
-	projectileNumber = 0;
-	while(projectileNumber < numProjectiles) {
+	// Move the highest projectiles first so that a projectile never moves
+	// into a cell that another projectile hasn't left yet. (Insertion sort
+	// on y - there are only a few projectiles.)
+	for(i = 0; i < num_entities; i++) {
+		projectile = entity_live[i];
+		if(entity_type[projectile] != ENTITY_PROJECTILE || count == MAX_PROJECTILES) {
+			continue;
+		}
+		y = GET_Y_POSITION(entity_position[projectile]);
+		for(j = count; j > 0 && 
+				GET_Y_POSITION(entity_position[order[j-1]]) < y; j--) {
+			order[j] = order[j-1];
+		}
+		order[j] = projectile;
+		count++;
+	}
+
+	for(i = 0; i < count; i++) {
+		projectile = order[i];
 		// Get the current position of the projectile
-		x = GET_X_POSITION(projectiles[projectileNumber]);
-		y = GET_Y_POSITION(projectiles[projectileNumber]);
+		x = GET_X_POSITION(entity_position[projectile]);
+		y = GET_Y_POSITION(entity_position[projectile]);
 		
 		// Work out the new position (but don't update the projectile 
 		// location yet - we only do that if we know the move is valid)
@@ -319,14 +508,7 @@ void advance_projectiles(void) {
 			// Yes - remove the projectile. (Note that we haven't updated
 			// the position of the projectile itself - so the projectile 
 			// will be removed from its old location.)
-			remove_projectile(projectileNumber);
-			// Note - we do not increment the projectileNumber here as
-			// the remove_projectile() function moves the later projectiles
-			// (if any) back down the list of projectiles so that
-			// the projectileNumber is now the next projectile to be
-			// dealt with (if we weren't at the last one in the list).
-			// remove_projectile() will also result in numProjectiles being
-			// decreased by 1
+			remove_entity(projectile);
 		} else {
 			// Projectile is not going off the top of the display
 			// CHECK HERE IF THE NEW PROJECTILE LOCATION CORRESPONDS TO
@@ -334,24 +516,24 @@ void advance_projectiles(void) {
 			// AND THE ASTEROID.
 			asteroid_location = asteroid_at(x, y);
 			if (asteroid_location != -1) {
-				handle_collision(asteroid_location, projectileNumber);
+				handle_collision(asteroid_location, projectile);
 			} else {	
 				// Remove the projectile from the display 
-				redraw_projectile(projectileNumber, COLOUR_BLACK);
+				redraw_projectile(projectile, COLOUR_BLACK);
+				projectile_rows[y - 1] &= ~FIELD_BIT(x);
 			
 				// Update the projectile's position
-				projectiles[projectileNumber] = GAME_POSITION(x,y);
+				entity_position[projectile] = GAME_POSITION(x,y);
+				projectile_rows[y] |= FIELD_BIT(x);
 			
 				// Redraw the projectile
-				redraw_projectile(projectileNumber, COLOUR_PROJECTILE);
-			
-				// Move on to the next projectile (we don't do this if a projectile
-				// is removed since projectiles will be shuffled in the list and the
-				// next projectile (if any) will take on the same projectile number)
-				projectileNumber++;
+				redraw_projectile(projectile, COLOUR_PROJECTILE);
 			}
 		}			
 	}
+	apply_queues();
+	lastTickCollisions = tickCollisions;
+	tickCollisions = 0;
 }
 
 
@@ -360,50 +542,257 @@ int8_t is_game_over(void) {
 	return (get_lives() == 0);
 }
 
+int8_t get_base_position(void) {
+	return basePosition;
+}
+
+FieldRow get_asteroid_row(uint8_t y) {
+	return asteroid_rows[y];
+}
+
+uint16_t get_game_checksum(void) {
+	// Fletcher-16 over the occupied cells, the base position, score
+	// and lives
+	uint8_t sum1 = 0;
+	uint8_t sum2 = 0;
+	FieldRow row;
+	
+	for(uint8_t y = 0; y < FIELD_HEIGHT; y++) {
+		row = asteroid_rows[y] ^ (projectile_rows[y] << 1);
+		for(uint8_t i = 0; i < sizeof(FieldRow); i++) {
+			sum1 += (uint8_t)row;
+			sum2 += sum1;
+			row >>= 8;
+		}
+	}
+	sum1 += basePosition;
+	sum2 += sum1;
+	sum1 += (uint8_t)get_score();
+	sum2 += sum1;
+	sum1 += get_lives();
+	sum2 += sum1;
+	return ((uint16_t)sum2 << 8) | sum1;
+}
+
+uint16_t get_tick_number(void) {
+	return tickNumber;
+}
+
+FieldRow get_base_footprint(void) {
+	FieldRow footprint = 0;
+	
+	for(uint8_t y = 0; y < BASE_ROWS; y++) {
+		footprint |= base_rows[y];
+	}
+	return footprint;
+}
+
 
 /******** INTERNAL FUNCTIONS ****************/
 
 // Change the state of game over
-void subtract_life() {
-	if (get_lives() != 0) {
-		add_to_lives(-1);
+void subtract_lives(uint8_t count) {
+	if (count > get_lives()) {
+		count = get_lives();
 	}
-	move_cursor(2, 6);
-	printf_P(PSTR("You have %lu lives remaining."), get_lives());
+	add_to_lives(-(int8_t)count);
 }
 
 
-// Check whether the base is at a given location.
-static int8_t base_at(uint8_t x, uint8_t y) {
-	if (y > 1) {
-		// This is too high for the base.
-		return 0;
+// One step of advance_asteroids(). The asteroids are dealt with from 
+// the bottom of the field up (left to right within a row), so an 
+// asteroid moves into space freed by the one below it this step. An 
+// asteroid that hasn't been dealt with yet counts as still being where
+// it was. The new positions and occupancy go into the spare buffers, 
+// which then become the current ones. Asteroids that leave the field or
+// hit something are left out of the new occupancy rows and queued for
+// removal (as is a projectile that is hit, so only one asteroid can 
+// hit it).
+static uint8_t step_asteroids(uint8_t* cells) {
+	GamePosition* next = entity_next_positions();
+	FieldRow* nextRows;
+	FieldRow waitingRows[FIELD_HEIGHT];
+	uint8_t order[MAX_ENTITIES];
+	uint8_t i, j, n, count, slot, x, y, shape;
+	uint16_t key;
+	int8_t row;
+	FieldRow overlap;
+	uint8_t moving = 0;
+	
+	nextRows = (asteroid_rows == asteroid_row_buffers[0]) ? 
+			asteroid_row_buffers[1] : asteroid_row_buffers[0];
+	
+	// Sort the asteroids by position - bottom row first (insertion sort,
+	// on y then x). Every entity keeps its position in the new buffer 
+	// unless it moves.
+	count = 0;
+	for(n = 0; n < num_entities; n++) {
+		slot = entity_live[n];
+		next[slot] = entity_position[slot];
+		if(entity_type[slot] != ENTITY_ASTEROID) {
+			continue;
+		}
+		key = ((uint16_t)GET_Y_POSITION(entity_position[slot]) << 8) | 
+				GET_X_POSITION(entity_position[slot]);
+		for(j = count; j > 0 && key < (((uint16_t)GET_Y_POSITION(entity_position[order[j-1]]) << 8) 
+				| GET_X_POSITION(entity_position[order[j-1]])); j--) {
+			order[j] = order[j-1];
+		}
+		order[j] = slot;
+		count++;
 	}
 	
-	if (x == basePosition) {
-		// This can occur for both y = 1 and y = 0.
-		return 1;
-	} else if (y == 0) {
-		// Check the sides of the base.
-		if (x == basePosition -1 || x == basePosition + 1) {
-			return 1;
+	for(y = 0; y < FIELD_HEIGHT; y++) {
+		waitingRows[y] = asteroid_rows[y];
+		nextRows[y] = 0;
+	}
+	
+	for(n = 0; n < count; n++) {
+		slot = order[n];
+		if(entity_flags[slot] & ENTITY_FLAG_GONE) {
+			// Already gone (in an earlier step)
+			continue;
+		}
+		x = GET_X_POSITION(entity_position[slot]);
+		y = GET_Y_POSITION(entity_position[slot]);
+		shape = entity_variant[slot];
+		mark_shape(waitingRows, shape, x, y, 0);
+		if(cells[slot] == 0) {
+			// Not moving any further this tick
+			mark_shape(nextRows, shape, x, y, 1);
+			continue;
+		}
+		cells[slot]--;
+		
+		// Check if new position would be off the bottom of the display
+		if(y == 0) {
+			// Replace it with a new one at the top
+			remove_entity(slot);
+			pendingAsteroids++;
+			continue;
+		}
+		
+		// Blocked by another asteroid - stay put for the rest of the tick
+		y = y - 1;
+		if(shape_overlap(shape, x, y, nextRows, FIELD_HEIGHT, &overlap) != -1 ||
+				shape_overlap(shape, x, y, waitingRows, FIELD_HEIGHT, &overlap) != -1) {
+			cells[slot] = 0;
+			mark_shape(nextRows, shape, x, y + 1, 1);
+			continue;
+		}
+		
+		// CHECK HERE IF THE NEW ASTEROID LOCATION COVERS A PROJECTILE
+		// OR THE BASE.
+		row = shape_overlap(shape, x, y, projectile_rows, FIELD_HEIGHT, &overlap);
+		if(row != -1) {
+			handle_collision(slot, projectile_at(lowest_bit(overlap), y + row));
+			continue;
+		}
+		if(shape_overlap(shape, x, y, base_rows, BASE_ROWS, &overlap) != -1) {
+			remove_entity(slot);
+			baseHits++;
+			continue;
+		}
+		
+		next[slot] = GAME_POSITION(x, y);
+		mark_shape(nextRows, shape, x, y, 1);
+		moving |= cells[slot];
+	}
+	
+	// Erase the asteroids that moved from their old positions, swap
+	// buffers, then draw them in their new positions
+	for(n = 0; n < count; n++) {
+		if(next[order[n]] != entity_position[order[n]]) {
+			redraw_asteroid(order[n], COLOUR_BLACK);
 		}
 	}
-	// No match was found
-	return 0;
+	entity_swap_positions();
+	asteroid_rows = nextRows;
+	for(n = 0; n < count; n++) {
+		i = order[n];
+		if(entity_position[i] != entity_next_positions()[i]) {
+			redraw_asteroid(i, COLOUR_ASTEROID);
+		}
+	}
+	return moving;
 }
 
+// Apply the queues filled in by an update (see removalQueue etc. at the
+// top of this file). Destroying the removed entities first makes room
+// in the pool and on the field for the fragments and new asteroids.
+static void apply_queues(void) {
+	uint8_t i;
+	AsteroidHit* hit;
+	
+	for(i = 0; i < numRemovals; i++) {
+		if(entity_is_live(removalQueue[i])) {
+			if(entity_type[ENTITY_SLOT(removalQueue[i])] == ENTITY_ASTEROID) {
+				numAsteroids--;
+			} else {
+				numProjectiles--;
+			}
+			spatial_remove(ENTITY_SLOT(removalQueue[i]));
+			entity_destroy(removalQueue[i]);
+		}
+	}
+	numRemovals = 0;
+	
+	// One point for each asteroid shot. The score changes once, however 
+	// many there were.
+	if(numHits) {
+		for(i = 0; i < numHits; i++) {
+			hit = &hitQueue[i];
+			asteroid_destroyed(GET_X_POSITION(hit->position), 
+					GET_Y_POSITION(hit->position), hit->shape, hit->velocity);
+		}
+		add_to_score(numHits);
+		tickCollisions += numHits;
+		numHits = 0;
+	}
+	
+	// If asteroids collided with the base, handle the event.
+	if(baseHits) {
+		tickCollisions += baseHits;
+		subtract_lives(baseHits);
+		redraw_hit_base();
+		baseHits = 0;
+	}
+	
+	// Add the new asteroids. Any that don't fit stay in pendingAsteroids
+	// until next time.
+	for(i = pendingAsteroids; i > 0; i--) {
+		pendingAsteroids--;
+		add_asteroid();
+	}
+}
 
 // Check whether there is an asteroid at a given position.
 // Returns -1 if there is no asteroid, otherwise we return
-// the asteroid number (from 0 to numAsteroids-1).
+// the asteroid's entity slot.
 static int8_t asteroid_at(uint8_t x, uint8_t y) {
-	uint8_t i;
-	uint8_t positionToCheck = GAME_POSITION(x,y);
-	for(i=0; i < numAsteroids; i++) {
-		if(asteroids[i] == positionToCheck) {
-			// Asteroid i is at the given position
-			return i;
+	uint8_t slot, asteroidY, bucket, firstBucket;
+	if(x >= FIELD_WIDTH || y >= FIELD_HEIGHT || 
+			!(asteroid_rows[y] & FIELD_BIT(x))) {
+		// Nothing there - no need to look at each asteroid
+		return -1;
+	}
+	// An asteroid covering column x starts at most ASTEROID_MAX_WIDTH - 1
+	// columns to the left, so it is in x's bucket or possibly the one 
+	// before.
+	firstBucket = (x < ASTEROID_MAX_WIDTH - 1) ? 0 : 
+			SPATIAL_BUCKET(x - (ASTEROID_MAX_WIDTH - 1));
+	for(bucket = SPATIAL_BUCKET(x) + 1; bucket-- > firstBucket; ) {
+		for(slot = spatial_first(bucket); slot != SPATIAL_END; slot = spatial_next[slot]) {
+			if(entity_type[slot] != ENTITY_ASTEROID || 
+					(entity_flags[slot] & ENTITY_FLAG_GONE)) {
+				continue;
+			}
+			asteroidY = GET_Y_POSITION(entity_position[slot]);
+			if(y >= asteroidY && (asteroid_row_mask(entity_variant[slot], 
+					y - asteroidY, GET_X_POSITION(entity_position[slot])) & FIELD_BIT(x))) {
+				// This asteroid covers the given position
+				return slot;
+			}
 		}
 	}
 	// No match was found - no asteroid at the given position
@@ -412,126 +801,273 @@ static int8_t asteroid_at(uint8_t x, uint8_t y) {
 
 // Check whether there is a projectile at a given position.
 // Returns -1 if there is no projectile, otherwise we return
-// the projectile number (from 0 to numProjectiles-1).
+// the projectile's entity slot.
 static int8_t projectile_at(uint8_t x, uint8_t y) {
-	uint8_t i;
-	uint8_t positionToCheck = GAME_POSITION(x,y);
-	for(i=0; i < numProjectiles; i++) {
-		if(projectiles[i] == positionToCheck) {
-			// Projectile i is at the given position
-			return i;
+	uint8_t slot;
+	GamePosition positionToCheck = GAME_POSITION(x,y);
+	if(x >= FIELD_WIDTH || y >= FIELD_HEIGHT ||
+			!(projectile_rows[y] & FIELD_BIT(x))) {
+		return -1;
+	}
+	for(slot = spatial_first(SPATIAL_BUCKET(x)); slot != SPATIAL_END; 
+			slot = spatial_next[slot]) {
+		if(entity_type[slot] == ENTITY_PROJECTILE && 
+				entity_position[slot] == positionToCheck &&
+				!(entity_flags[slot] & ENTITY_FLAG_GONE)) {
+			// This projectile is at the given position
+			return slot;
 		}
 	}
 	// No match was found - no projectile at the given position 
 	return -1;
 }
 
-/* Remove asteroid with the given index number (from 0 to
-** numAsteroids - 1).
+// Shift an 8 bit sprite row so that its left column is at field column
+// x. x may be negative, in which case columns are lost off the left.
+static FieldRow shift_row(uint8_t bits, int8_t x) {
+	if(x < 0) {
+		return (FieldRow)(bits >> -x);
+	}
+	return (FieldRow)bits << x;
+}
+
+// Row "row" (0 is the bottom) of an asteroid shape with its left column
+// at field column x. Rows above the top of the shape are empty.
+static FieldRow asteroid_row_mask(uint8_t shape, uint8_t row, uint8_t x) {
+	return shift_row(sprite_mask_row(&sprite_asteroid[shape], row), x);
+}
+
+// Check whether an asteroid of the given shape at (x,y) would overlap
+// any of the cells set in rows[0] to rows[numRows-1]. Returns the 
+// row of the shape (0 is the bottom) with the first overlap, and the
+// overlapping cells in that row in *overlap, or -1 if there is no overlap.
+static int8_t shape_overlap(uint8_t shape, uint8_t x, uint8_t y,
+		const FieldRow* rows, uint8_t numRows, FieldRow* overlap) {
+	uint8_t height = sprite_height(&sprite_asteroid[shape]);
+	for(uint8_t row = 0; row < height && y + row < numRows; row++) {
+		*overlap = rows[y + row] & asteroid_row_mask(shape, row, x);
+		if(*overlap) {
+			return row;
+		}
+	}
+	return -1;
+}
+
+// Set (occupied = 1) or clear (occupied = 0) the cells covered by an
+// asteroid of the given shape at (x,y) in rows[].
+static void mark_shape(FieldRow* rows, uint8_t shape, uint8_t x, uint8_t y, 
+		uint8_t occupied) {
+	uint8_t height = sprite_height(&sprite_asteroid[shape]);
+	FieldRow mask;
+	for(uint8_t row = 0; row < height && y + row < FIELD_HEIGHT; row++) {
+		mask = asteroid_row_mask(shape, row, x);
+		if(occupied) {
+			rows[y + row] |= mask;
+		} else {
+			rows[y + row] &= ~mask;
+		}
+	}
+}
+
+// As above for the given asteroid in asteroid_rows.
+static void mark_asteroid(uint8_t asteroid, uint8_t occupied) {
+	mark_shape(asteroid_rows, entity_variant[asteroid], 
+			GET_X_POSITION(entity_position[asteroid]), 
+			GET_Y_POSITION(entity_position[asteroid]), occupied);
+}
+
+// Recalculate base_rows after the base has moved.
+static void update_base_rows(void) {
+	for(uint8_t row = 0; row < BASE_ROWS; row++) {
+		base_rows[row] = shift_row(sprite_mask_row(&BASE_SPRITE, row), 
+				basePosition - BASE_CENTRE);
+	}
+}
+
+// Work out which buckets are near enough to the display to be moved 
+// every tick.
+static void update_near_buckets(void) {
+	uint8_t last = viewport_x + VIEW_WIDTH - 1 + FAR_MARGIN;
+	nearFirstBucket = (viewport_x < FAR_MARGIN) ? 0 : 
+			SPATIAL_BUCKET(viewport_x - FAR_MARGIN);
+	nearLastBucket = SPATIAL_BUCKET(last >= FIELD_WIDTH ? FIELD_WIDTH - 1 : last);
+}
+
+// Remove every asteroid that overlaps the base. Returns the number of
+// asteroids removed.
+static uint8_t remove_asteroids_on_base(void) {
+	uint8_t removed = 0;
+	int8_t asteroid;
+	FieldRow hits;
+	for(uint8_t row = 0; row < BASE_ROWS; row++) {
+		// Removing an asteroid clears its cells, so keep going until
+		// nothing in this row overlaps the base
+		while((hits = base_rows[row] & asteroid_rows[row]) != 0) {
+			asteroid = asteroid_at(lowest_bit(hits), row);
+			if(asteroid == -1) {
+				break;
+			}
+			remove_entity(asteroid);
+			removed++;
+		}
+	}
+	return removed;
+}
+
+// Return the column number of the lowest set bit. bits must not be 0.
+static uint8_t lowest_bit(FieldRow bits) {
+	uint8_t x = 0;
+	while(!(bits & 1)) {
+		bits >>= 1;
+		x++;
+	}
+	return x;
+}
+
+/* Take the entity in the given slot off the field - it is destroyed
+** later by apply_queues().
 */
-static void remove_asteroid(int8_t asteroidNumber) {
-	if(asteroidNumber < 0 || asteroidNumber >= numAsteroids) {
-		// Invalid index - do nothing
+static void remove_entity(int8_t slot) {
+	if(slot < 0 || (entity_flags[slot] & ENTITY_FLAG_GONE)) {
+		// Invalid slot or already removed - do nothing
 		return;
 	}
 	
-	// Remove the asteroid from the display
-	redraw_asteroid(asteroidNumber, COLOUR_BLACK);
-	
-	if(asteroidNumber < numAsteroids - 1) {
-		// Asteroid is not the last one in the list
-		// - move the last one in the list to this position
-		asteroids[asteroidNumber] = asteroids[numAsteroids - 1];
-		asteroid_speeds[asteroidNumber] = asteroid_speeds[numAsteroids - 1];
+	// Remove the entity from the display and the occupancy rows
+	if(entity_type[slot] == ENTITY_ASTEROID) {
+		redraw_asteroid(slot, COLOUR_BLACK);
+		mark_asteroid(slot, 0);
+	} else {
+		redraw_projectile(slot, COLOUR_BLACK);
+		projectile_rows[GET_Y_POSITION(entity_position[slot])] &= 
+				~FIELD_BIT(GET_X_POSITION(entity_position[slot]));
 	}
-	// Last position in asteroids array is no longer used
-	numAsteroids--;
+	entity_flags[slot] |= ENTITY_FLAG_GONE;
+	removalQueue[numRemovals++] = entity_handle(slot);
 }
 
 // Add an asteroid into the display, somewhere in the top two rows.
 static void add_asteroid() {
-	uint8_t x, y;
-	// Generate random position that does not already
-	// have an asteroid.
-	do {
+	uint8_t x, y, shape;
+	int8_t asteroid;
+	if(numAsteroids >= MAX_ASTEROIDS) {
+		// No room for another asteroid (e.g. after a split)
+		return;
+	}
+	// Generate random positions until we find one where the asteroid
+	// fits. If the top of the field is too crowded we give up and try 
+	// again on the next advance.
+	shape = random_shape();
+	for(uint8_t attempt = 0; attempt < PLACEMENT_ATTEMPTS; attempt++) {
 		// Generate random x position - somewhere from 0
-		// to FIELD_WIDTH - 1
-		x = (uint8_t)(random() % FIELD_WIDTH);
-		// Generate random y position - somewhere from
-		// FIELD_HEIGHT - 1 to FIELD_HEIGHT - 2
-		y = (uint8_t)(FIELD_HEIGHT - 1 - (random() % 2));
-	} while(asteroid_at(x,y) != -1);
-	// If we get here, we've now found an x,y location without
-	// an existing asteroid - record the position
-	asteroids[numAsteroids] = GAME_POSITION(x,y);
-	asteroid_speeds[numAsteroids] = (uint8_t)(random() % 4);
-	numAsteroids++;
-	
-	// Add the asteroid to the display
-	redraw_asteroid(numAsteroids - 1, COLOUR_ASTEROID);
+		// to FIELD_WIDTH - width
+		x = (uint8_t)(random() % (FIELD_WIDTH + 1 - 
+				sprite_width(&sprite_asteroid[shape])));
+		// Generate random y position - the top of the shape is in
+		// row FIELD_HEIGHT - 1 or FIELD_HEIGHT - 2
+		y = (uint8_t)(FIELD_HEIGHT - sprite_height(&sprite_asteroid[shape]) 
+				- (random() % 2));
+		asteroid = place_asteroid(shape, x, y, random_velocity());
+		if(asteroid != -1) {
+			// Add the asteroid to the display
+			redraw_asteroid(asteroid, COLOUR_ASTEROID);
+			return;
+		}
+	}
+	pendingAsteroids++;
 }
 
-
-// Remove projectile with the given projectile number (from 0 to
-// numProjectiles - 1).
-static void remove_projectile(int8_t projectileNumber) {	
-	if(projectileNumber < 0 || projectileNumber >= numProjectiles) {
-		// Invalid index - do nothing 
-		return;
+// Add an asteroid with the given shape and velocity at (x,y) provided the
+// whole shape is on the field and doesn't overlap another asteroid, a
+// projectile or the base. The asteroid is not drawn.
+static int8_t place_asteroid(uint8_t shape, int8_t x, uint8_t y, uint16_t velocity) {
+	FieldRow overlap;
+	EntityHandle asteroid;
+	uint8_t slot;
+	if(numAsteroids >= MAX_ASTEROIDS || x < 0 ||
+			x + sprite_width(&sprite_asteroid[shape]) > FIELD_WIDTH ||
+			y + sprite_height(&sprite_asteroid[shape]) > FIELD_HEIGHT) {
+		return -1;
 	}
-	
-	// Remove the projectile from the display
-	redraw_projectile(projectileNumber, COLOUR_BLACK);
-	
-	// Close up the gap in the list of projectiles - move any
-	// projectiles after this in the list closer to the start of the list
-	for(uint8_t i = projectileNumber+1; i < numProjectiles; i++) {
-		projectiles[i-1] = projectiles[i];
+	if(shape_overlap(shape, x, y, asteroid_rows, FIELD_HEIGHT, &overlap) != -1 ||
+			shape_overlap(shape, x, y, projectile_rows, FIELD_HEIGHT, &overlap) != -1 ||
+			shape_overlap(shape, x, y, base_rows, BASE_ROWS, &overlap) != -1) {
+		return -1;
 	}
-	// Update projectile count - have one fewer projectiles now.
-	numProjectiles--;
+	asteroid = entity_create(ENTITY_ASTEROID);
+	if(asteroid == INVALID_ENTITY) {
+		return -1;
+	}
+	slot = ENTITY_SLOT(asteroid);
+	entity_position[slot] = GAME_POSITION(x,y);
+	entity_velocity[slot] = velocity;
+	entity_variant[slot] = shape;
+	spatial_insert(slot);
+	mark_asteroid(slot, 1);
+	numAsteroids++;
+	return slot;
 }
 
-
-uint8_t game_over_animation(uint32_t current_time, uint8_t animation_number) {
-	static uint32_t previous_time;
-	if (current_time > previous_time + 100 && animation_number == 1) {
-		ledmatrix_shift_display_right();
-		previous_time = current_time;
-		return 1;
-	} else if (animation_number == 2) {
-		set_scrolling_display_text("GAME OVER NERD", COLOUR_GREEN);
-		return 1;
-	} else if (current_time > previous_time + 100 && scroll_display() 
-	&& animation_number == 3) {
-		previous_time = current_time;
-		return 1;
-	} else if (current_time > previous_time + 100 && animation_number == 3) {
-		previous_time = current_time;
-		return 1;
-	} else if (animation_number == 4) {
-		set_scrolling_display_text("GG", COLOUR_GREEN);
-		return 1;
-	} else if (current_time > previous_time + 100 && scroll_display()
-	&& animation_number == 5) {
-		previous_time = current_time;
-		return 1;
+// Break an asteroid that has been hit into the fragments given in
+// asteroid_splits. Fragments that would be off the field or land on 
+// something else are dropped.
+static uint8_t split_asteroid(uint8_t shape, uint8_t x, uint8_t y, uint16_t velocity) {
+	uint8_t added = 0;
+	uint8_t fragment;
+	int8_t asteroid;
+	for(uint8_t i = 0; i < 2; i++) {
+		fragment = pgm_read_byte(&asteroid_splits[shape].shape[i]);
+		if(fragment == ASTEROID_NONE) {
+			continue;
+		}
+		asteroid = place_asteroid(fragment, 
+				x + (int8_t)pgm_read_byte(&asteroid_splits[shape].offset[i]), 
+				y, velocity);
+		if(asteroid != -1) {
+			redraw_asteroid(asteroid, COLOUR_ASTEROID);
+			added++;
+		}
 	}
-	return 0;
+	return added;
+}
+
+// Choose a velocity for a new asteroid - anywhere from one cell every
+// ASTEROID_SLOWEST_MS to one cell every ASTEROID_FASTEST_MS.
+static uint16_t random_velocity(void) {
+	return ASTEROID_VELOCITY(ASTEROID_SLOWEST_MS) + (uint16_t)(random() % 
+			(ASTEROID_VELOCITY(ASTEROID_FASTEST_MS) - 
+			ASTEROID_VELOCITY(ASTEROID_SLOWEST_MS) + 1));
 }
 
-// Remove the projectile and asteroid when they collide. Incrementing score.
-// Sound effects can be handled here as well.
-static void handle_collision(int8_t asteroidIndex, int8_t projectileIndex) {
+// Choose the shape of a new asteroid.
+static uint8_t random_shape(void) {
+	return pgm_read_byte(&random_shape_table[random() % 8]);
+}
+
+
+// Remove the projectile and asteroid when they collide, and queue the
+// asteroid to be broken up and scored.
+static void handle_collision(int8_t asteroid, int8_t projectile) {
+	AsteroidHit* hit = &hitQueue[numHits++];
+	hit->position = entity_position[asteroid];
+	hit->shape = entity_variant[asteroid];
+	hit->velocity = entity_velocity[asteroid];
 	// Remove the collided particles.
-	remove_projectile(projectileIndex);
-	remove_asteroid(asteroidIndex);
-	add_asteroid();
-	// Add one to the score
-	add_to_score(1);
-	// Output the score to the console - Potential to handle this in project.c
-	move_cursor(2,4);
-	printf_P(PSTR("Score: %lu"), get_score());
+	remove_entity(asteroid);
+	remove_entity(projectile);
+}
+
+// Break up or replace an asteroid that was shot. (The score is added by
+// apply_queues().) Sound effects can be handled here as well.
+static void asteroid_destroyed(uint8_t x, uint8_t y, uint8_t shape, 
+		uint16_t velocity) {
+	// Throw out some debris from where the asteroid was
+	particles_burst(x, y, COLOUR_ORANGE);
+	// Larger asteroids break up. Single asteroids (or ones with no
+	// room to break up) are replaced by a new one at the top.
+	if(split_asteroid(shape, x, y, velocity) == 0) {
+		pendingAsteroids++;
+	}
 }
 
 
@@ -539,7 +1075,7 @@ static void handle_collision(int8_t asteroidIndex, int8_t projectileIndex) {
 // We assume all of the data structures have been appropriately populated
 static void redraw_whole_display(void) {
 	// clear the display
-	ledmatrix_clear();
+	framebuffer_clear();
 	
 	// Redraw each of the elements
 	redraw_base(COLOUR_BASE);
@@ -549,14 +1085,11 @@ static void redraw_whole_display(void) {
 
 
 static void redraw_base(uint8_t colour){
-	// Add the bottom row of the base first (0) followed by the single bit
-	// in the next row (1)
-	for(int8_t x = basePosition - 1; x <= basePosition + 1; x++) {
-		if (x >= 0 && x < FIELD_WIDTH) {
-			ledmatrix_update_pixel(LED_MATRIX_POSN_FROM_XY(x, 0), colour);
-		}
-	}
-	ledmatrix_update_pixel(LED_MATRIX_POSN_FROM_XY(basePosition, 1), colour);
+	// The base sprite is anchored at its bottom left corner, BASE_CENTRE
+	// columns left of the centre. The sprite is clipped at the field edges.
+	framebuffer_select_layer(LAYER_BASE);
+	sprite_draw(&BASE_SPRITE, basePosition - BASE_CENTRE, 0, colour);
+	framebuffer_select_layer(LAYER_FIELD);
 }
 
 
@@ -567,65 +1100,108 @@ static void redraw_hit_base(void) {
 	uint32_t current_time = start_time;
 	uint32_t flicker_time = start_time;
 	init_sound();
+	// Dim the rest of the field so the explosion stands out
+	palette_set_layer_brightness(LAYER_FIELD, BRIGHTNESS_MAX / 3);
 	while(current_time < start_time + 1000) {
 		random_sound();
 		display_data(current_time);
 		current_time = get_current_time();
+		framebuffer_select_layer(LAYER_EFFECTS);
 		if (current_time == flicker_time + 250) {
-			redraw_base(COLOUR_BLACK);
+			sprite_draw(&sprite_explosion[0], basePosition - BASE_CENTRE, 0, COLOUR_BLACK);
 		} 
 		if (current_time == flicker_time + 500) {
-			redraw_base(COLOUR_PROJECTILE);
+			sprite_draw(&sprite_explosion[1], basePosition - BASE_CENTRE, 0, COLOUR_BLACK);
 		}
+		framebuffer_select_layer(LAYER_FIELD);
 		if (current_time == flicker_time + 750) {
+			sprite_erase(&sprite_explosion[0], basePosition - BASE_CENTRE, 0);
 			redraw_base(COLOUR_GREEN);
 			flicker_time = current_time;
 		}
+		framebuffer_flush();
 	}
 	kill_sound();
 	update_time(start_time - 3);
 	set_clock_ticks(start_time);
-	// Clear a button push or serial input if any are waiting
+	// Clear a button push if one is waiting. Serial input is left alone -
+	// it may hold part of a remote control frame.
 	// (The cast to void means the return value is ignored.)
 	(void)button_pushed();
-	clear_serial_input_buffer();
+	// The explosion may have drawn over asteroids near the base. Only the
+	// pixels that actually change are sent on the next flush.
+	sprite_erase(&sprite_explosion[0], basePosition - BASE_CENTRE, 0);
+	redraw_all_asteroids();
+	redraw_all_projectiles();
 	redraw_base(COLOUR_BASE);
+	palette_set_layer_brightness(LAYER_FIELD, BRIGHTNESS_MAX);
 }
 
 
 static void redraw_all_asteroids(void) {
-	// For each asteroid, determine it's position and redraw it
-	for(uint8_t i=0; i < numAsteroids; i++) {
-		redraw_asteroid(i, COLOUR_ASTEROID);
+	uint8_t slot;
+	// For each asteroid that may be in view, determine it's position and
+	// redraw it
+	for(uint8_t bucket = first_visible_bucket(); bucket <= last_visible_bucket(); bucket++) {
+		for(slot = spatial_first(bucket); slot != SPATIAL_END; slot = spatial_next[slot]) {
+			if(entity_type[slot] == ENTITY_ASTEROID && 
+					!(entity_flags[slot] & ENTITY_FLAG_GONE)) {
+				redraw_asteroid(slot, COLOUR_ASTEROID);
+			}
+		}
 	}
 }
 
 
-static void redraw_asteroid(uint8_t asteroidNumber, uint8_t colour) {
-	uint8_t asteroidPosn;
-	if(asteroidNumber < numAsteroids) {
-		asteroidPosn = asteroids[asteroidNumber];
-		ledmatrix_update_pixel(LED_MATRIX_POSN_FROM_GAME_POSN(asteroidPosn), colour);
-	}
+static void redraw_asteroid(uint8_t asteroid, uint8_t colour) {
+	GamePosition asteroidPosn = entity_position[asteroid];
+	sprite_draw(&sprite_asteroid[entity_variant[asteroid]],
+			GET_X_POSITION(asteroidPosn), GET_Y_POSITION(asteroidPosn), colour);
 }
 
 
 static void redraw_all_projectiles(void){
-	// For each projectile, determine its position and redraw it
-	for(uint8_t i = 0; i < numProjectiles; i++) {
-		redraw_projectile(i, COLOUR_PROJECTILE);
+	uint8_t slot;
+	// For each projectile that may be in view, determine its position 
+	// and redraw it
+	for(uint8_t bucket = first_visible_bucket(); bucket <= last_visible_bucket(); bucket++) {
+		for(slot = spatial_first(bucket); slot != SPATIAL_END; slot = spatial_next[slot]) {
+			if(entity_type[slot] == ENTITY_PROJECTILE && 
+					!(entity_flags[slot] & ENTITY_FLAG_GONE)) {
+				redraw_projectile(slot, COLOUR_PROJECTILE);
+			}
+		}
 	}
 }
 
 
-static void redraw_projectile(uint8_t projectileNumber, uint8_t colour) {
-	uint8_t projectilePosn;
-	
-	// Check projectileNumber is valid - ignore otherwise
-	if(projectileNumber < numProjectiles) {
-		projectilePosn = projectiles[projectileNumber];
-		ledmatrix_update_pixel(LED_MATRIX_POSN_FROM_GAME_POSN(projectilePosn), colour);
+static void redraw_projectile(uint8_t projectile, uint8_t colour) {
+	GamePosition projectilePosn = entity_position[projectile];
+	framebuffer_set_address(LED_MATRIX_ADDRESS_FROM_GAME_POSN(projectilePosn), colour);
+}
+
+
+// Draw column x of the field, which has just scrolled into view (and so
+// is black). The occupancy rows say what is in it.
+static void redraw_column(uint8_t x) {
+	for(uint8_t y = 0; y < FIELD_HEIGHT; y++) {
+		if(asteroid_rows[y] & FIELD_BIT(x)) {
+			framebuffer_set_address(LED_MATRIX_ADDRESS_FROM_XY(x, y), COLOUR_ASTEROID);
+		} else if(projectile_rows[y] & FIELD_BIT(x)) {
+			framebuffer_set_address(LED_MATRIX_ADDRESS_FROM_XY(x, y), COLOUR_PROJECTILE);
+		}
 	}
 }
 
 
+// The spatial index buckets which may hold something in view (an 
+// asteroid may start up to ASTEROID_MAX_WIDTH - 1 columns left of the
+// display).
+static uint8_t first_visible_bucket(void) {
+	return (viewport_x < ASTEROID_MAX_WIDTH - 1) ? 0 : 
+			SPATIAL_BUCKET(viewport_x - (ASTEROID_MAX_WIDTH - 1));
+}
+
+static uint8_t last_visible_bucket(void) {
+	return SPATIAL_BUCKET(viewport_x + VIEW_WIDTH - 1);
+}
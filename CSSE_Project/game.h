@@ -10,21 +10,99 @@
 #define GAME_H_
 
 #include <inttypes.h>
+#include "orientation.h"
+#include "viewport.h"
 
-// The game field is 16 rows in size by 8 columns, i.e. x (column number)
-// ranges from 0 to 7 (left to right) and y (row number) ranges from
-// 0 to 15 (bottom to top).
-#define FIELD_HEIGHT 16
-#define FIELD_WIDTH 8
+// The game field is FIELD_HEIGHT rows in size by FIELD_WIDTH columns, 
+// i.e. x (column number) ranges from 0 to FIELD_WIDTH - 1 (left to 
+// right) and y (row number) ranges from 0 to FIELD_HEIGHT - 1 (bottom to
+// top). The display shows VIEW_WIDTH columns of it at a time, following
+// the base (see viewport.h). The display is 8 columns by 16 rows, and 8
+// columns wider per extra LED matrix panel. (If the display is mounted 
+// in landscape orientation - see orientation.h - it is 8 rows by 16 
+// columns per panel instead.) The field is the height of the display. 
+// FIELD_WIDTH can be overridden by defining it as a compiler symbol.
+// Each row of the field is FIELD_WIDTH / 8 bytes, and game.c keeps
+// three sets of rows (the asteroids, double buffered, and the 
+// projectiles) plus a fourth on the stack while the asteroids move. At
+// 64 columns that is 512 bytes of the ATmega324A's 2K of RAM, so the
+// default is 32 columns unless the display itself is wider.
+#ifndef FIELD_WIDTH
+#if VIEW_WIDTH > 32
+#define FIELD_WIDTH 64
+#else
+#define FIELD_WIDTH 32
+#endif
+#endif
+#define FIELD_HEIGHT VIEW_HEIGHT
+
+#if FIELD_WIDTH < VIEW_WIDTH
+#error "FIELD_WIDTH must be at least as wide as the display"
+#endif
+
+// One row of the game field as a bit mask - bit x is set if column x of
+// the row is occupied. The type is exactly FIELD_WIDTH bits wide so that
+// anything shifted off the right hand edge of the field is discarded.
+#if FIELD_WIDTH == 8
+typedef uint8_t FieldRow;
+#elif FIELD_WIDTH == 16
+typedef uint16_t FieldRow;
+#elif FIELD_WIDTH == 32
+typedef uint32_t FieldRow;
+#elif FIELD_WIDTH == 64
+typedef uint64_t FieldRow;
+#else
+#error "FIELD_WIDTH must be 8, 16, 32 or 64"
+#endif
+#define FIELD_BIT(x)	((FieldRow)1 << (x))
+
+// Game positions (x,y) are represented in a single 16 bit unsigned 
+// integer where the most significant 8 bits are the x value and the 
+// least significant 8 bits are the y value. (This allows fields of
+// more than one panel.) The following macros allow the extraction of 
+// x and y values from a combined position value and the construction 
+// of a combined position value from separate x, y values. Values are
+// assumed to be in valid ranges. We use all 1's to represent an invalid
+// position.
+typedef uint16_t GamePosition;
+#define GAME_POSITION(x,y)		((GamePosition)(((uint16_t)(x) << 8) | (uint8_t)(y)))
+#define GET_X_POSITION(posn)	((uint8_t)((posn) >> 8))
+#define GET_Y_POSITION(posn)	((uint8_t)(posn))
+#define INVALID_POSITION		0xFFFF
+
+// Macros to convert a game position to the LED matrix address of that
+// pixel (as used by framebuffer_set_address()), or INVALID_MATRIX_ADDRESS
+// if it is out of view. The mapping depends on where the viewport is 
+// and how the display is mounted (see viewport.h and orientation.h).
+#define LED_MATRIX_ADDRESS_FROM_XY(gameX, gameY)	\
+		viewport_address(gameX, gameY)
+#define LED_MATRIX_ADDRESS_FROM_GAME_POSN(posn)	\
+		LED_MATRIX_ADDRESS_FROM_XY(GET_X_POSITION(posn), GET_Y_POSITION(posn))
 
 // Limits on the number of asteroids and projectiles we can have on the 
 // game field at any one time. (These numbers should fit within the 
 // range of an int8_t type - i.e. max 127, though in reality
-// there are tighter constraints than this - e.g. there are only 128
-// positions on the game field.)
+// there are tighter constraints than this - together they size the 
+// entity pool (see entity.h), which costs 15 bytes of RAM per
+// entry.)
 #define MAX_PROJECTILES 4
 #define MAX_ASTEROIDS 20
 
+// advance_asteroids() should be called every ASTEROID_TICK_MS 
+// milliseconds. Asteroid velocities are in cells per tick as 8.8 fixed
+// point numbers (256 is one cell per tick) - ASTEROID_VELOCITY gives the 
+// velocity for an asteroid which falls one cell every "ms" milliseconds.
+// New asteroids fall at a random speed between ASTEROID_SLOWEST_MS and
+// ASTEROID_FASTEST_MS per cell (before scaling - see below).
+#define ASTEROID_TICK_MS		250
+#define ASTEROID_VELOCITY(ms)	((uint16_t)((256UL * ASTEROID_TICK_MS) / (ms)))
+#define ASTEROID_SLOWEST_MS		6000
+#define ASTEROID_FASTEST_MS		1500
+
+// Multipliers for set_asteroid_speed_scale() (8.8 fixed point)
+#define ASTEROID_SPEED_SCALE_NORMAL	0x100
+#define ASTEROID_SPEED_SCALE_MAX	0x400
+
 // Arguments that can be passed to move_base() below
 #define MOVE_LEFT 0
 #define MOVE_RIGHT 1
@@ -43,21 +121,46 @@ int8_t move_base(int8_t direction);
 // the maximum number of projectiles in flight has been reached.
 int8_t fire_projectile(void);
 
-// Advance the asteroids. Any asteroids that
+// Advance the asteroids by one tick. Any asteroids that
 // are hit or fall exit the screen are destroyed.
 void advance_asteroids(void);
 
+// Set how much faster than their own velocity all asteroids fall, as an
+// 8.8 fixed point multiplier from 0 to ASTEROID_SPEED_SCALE_MAX (larger
+// values are clamped). This allows the game to speed up smoothly.
+void set_asteroid_speed_scale(uint16_t scale);
+uint16_t get_asteroid_speed_scale(void);
+
 // Advance the projectiles that have been fired. Any projectiles that
 // go off the top or that hit an asteroid are removed.
 void advance_projectiles(void);
 
+// The number of collisions (asteroids hitting projectiles or the base)
+// in the last asteroid or projectile tick, i.e. the last call to 
+// advance_asteroids() or advance_projectiles(). Collisions caused by 
+// move_base() or fire_projectile() count towards the next tick.
+uint8_t get_tick_collisions(void);
+
 // Returns 1 if the game is over, 0 otherwise
 int8_t is_game_over(void);
 
-// Changes the state of the lives variable.
-void subtract_life();
+// The game state, as read by the autopilot (see autopilot.h).
+// get_base_position() - the column the centre of the base is in.
+// get_asteroid_row() - the cells of row y covered by asteroids.
+// get_base_footprint() - the columns the base covers (in any row).
+int8_t get_base_position(void);
+FieldRow get_asteroid_row(uint8_t y);
+FieldRow get_base_footprint(void);
+
+// A checksum of the game state, used to check two boards running the
+// same game still agree (see lockstep.h).
+uint16_t get_game_checksum(void);
+
+// The number of asteroid ticks (calls to advance_asteroids()) since the
+// game started.
+uint16_t get_tick_number(void);
 
-// Fancy game over stuff
-uint8_t game_over_animation(uint32_t current_time, uint8_t animation_number);
+// Take count lives away (stopping at zero).
+void subtract_lives(uint8_t count);
 
 #endif
@@ -0,0 +1,47 @@
+/*
+ * hud.c
+ *
+ * Written by Matt Burton
+ */
+
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+
+#include "hud.h"
+#include "score.h"
+#include "lives.h"
+#include "seven_seg.h"
+
+// The lives LEDs are on the top four bits of PORTA (the bottom four are
+// the joystick and LED matrix panel selects), indexed by the number of
+// lives.
+#define LIVES_LED_MASK	0xF0
+static const uint8_t lives_leds[MAX_LIVES + 1] PROGMEM = {
+	0x00, 0x40, 0x60, 0x70, 0xF0
+};
+
+// The score and lives versions when they were last drawn
+static uint8_t drawn_score_version;
+static uint8_t drawn_lives_version;
+
+void hud_invalidate(void) {
+	drawn_score_version = get_score_version() - 1;
+	drawn_lives_version = get_lives_version() - 1;
+}
+
+void hud_update(void) {
+	uint8_t lives;
+
+	if(drawn_score_version != get_score_version()) {
+		drawn_score_version = get_score_version();
+		set_value(get_score());
+	}
+	if(drawn_lives_version != get_lives_version()) {
+		drawn_lives_version = get_lives_version();
+		lives = get_lives();
+		if(lives > MAX_LIVES) {
+			lives = MAX_LIVES;
+		}
+		PORTA = (PORTA & ~LIVES_LED_MASK) | pgm_read_byte(&lives_leds[lives]);
+	}
+}
@@ -0,0 +1,23 @@
+/*
+ * hud.h
+ *
+ * Author: Matt Burton
+ *
+ * The score and lives shown on the seven segment display and the lives
+ * LEDs (the serial terminal's are drawn by termui - see termui.h). 
+ * hud_update(), called once each time through the main loop, watches 
+ * the score and lives version counters (see score.h and lives.h) and 
+ * only redraws an item when its value has changed.
+ */
+
+#ifndef HUD_H_
+#define HUD_H_
+
+#include <stdint.h>
+
+// Redraw everything on the next hud_update() (e.g. after the terminal
+// has been cleared).
+void hud_invalidate(void);
+void hud_update(void);
+
+#endif /* HUD_H_ */
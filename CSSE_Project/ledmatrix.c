@@ -17,11 +17,56 @@
 #define CMD_SHIFT_DISPLAY 0x04
 #define CMD_CLEAR_SCREEN 0x0F
 
+#if LEDMATRIX_NUM_PANELS != 1 && LEDMATRIX_NUM_PANELS != 2 && LEDMATRIX_NUM_PANELS != 4
+#error "LEDMATRIX_NUM_PANELS must be 1, 2 or 4"
+#endif
+
+// Slave select lines. Panel 0 uses the SPI SS pin (port B, pin 4). The
+// additional panels use port A pins 2 and 3 and port D pin 5.
+static volatile uint8_t* const panel_ss_port[4] = {&PORTB, &PORTA, &PORTA, &PORTD};
+static volatile uint8_t* const panel_ss_ddr[4] = {&DDRB, &DDRA, &DDRA, &DDRD};
+static const uint8_t panel_ss_pin[4] = {4, 2, 3, 5};
+
+static uint8_t selected_panel;
+
 void ledmatrix_setup(void) {
 	// Setup SPI - we divide the clock by 128.
 	// (This speed guarantees the SPI buffer will never overflow on
 	// the LED matrix.)
 	spi_setup_master(128);
+	
+	// Make the extra slave select lines outputs and deselect them.
+	// (spi_setup_master() has already selected panel 0.)
+	for(uint8_t panel = 1; panel < LEDMATRIX_NUM_PANELS; panel++) {
+		*panel_ss_ddr[panel] |= (1 << panel_ss_pin[panel]);
+		*panel_ss_port[panel] |= (1 << panel_ss_pin[panel]);
+	}
+	selected_panel = 0;
+}
+
+void ledmatrix_select_panel(uint8_t panel) {
+	if(panel >= LEDMATRIX_NUM_PANELS || panel == selected_panel) {
+		return;
+	}
+	// Take the old panel's slave select line high before taking the
+	// new one low
+	*panel_ss_port[selected_panel] |= (1 << panel_ss_pin[selected_panel]);
+	*panel_ss_port[panel] &= ~(1 << panel_ss_pin[panel]);
+	selected_panel = panel;
+}
+
+// Send a command which applies to every panel, leaving the original
+// panel selected.
+static void send_to_all_panels(uint8_t command, uint8_t argument, uint8_t has_argument) {
+	uint8_t original_panel = selected_panel;
+	for(uint8_t panel = 0; panel < LEDMATRIX_NUM_PANELS; panel++) {
+		ledmatrix_select_panel(panel);
+		(void)spi_send_byte(command);
+		if(has_argument) {
+			(void)spi_send_byte(argument);
+		}
+	}
+	ledmatrix_select_panel(original_panel);
 }
 
 void ledmatrix_update_all(MatrixData data) {
@@ -68,27 +113,23 @@ void ledmatrix_update_column(uint8_t x, MatrixColumn col) {
 }
 
 void ledmatrix_shift_display_left(void) {
-	(void)spi_send_byte(CMD_SHIFT_DISPLAY);
-	(void)spi_send_byte(0x02);
+	send_to_all_panels(CMD_SHIFT_DISPLAY, 0x02, 1);
 }
 
 void ledmatrix_shift_display_right(void) {
-	(void)spi_send_byte(CMD_SHIFT_DISPLAY);
-	(void)spi_send_byte(0x01);
+	send_to_all_panels(CMD_SHIFT_DISPLAY, 0x01, 1);
 }
 
 void ledmatrix_shift_display_up(void) {
-	(void)spi_send_byte(CMD_SHIFT_DISPLAY);
-	(void)spi_send_byte(0x08);
+	send_to_all_panels(CMD_SHIFT_DISPLAY, 0x08, 1);
 }
 
 void ledmatrix_shift_display_down(void) {
-	(void)spi_send_byte(CMD_SHIFT_DISPLAY);
-	(void)spi_send_byte(0x04);
+	send_to_all_panels(CMD_SHIFT_DISPLAY, 0x04, 1);
 }
 
 void ledmatrix_clear(void) {
-	(void)spi_send_byte(CMD_CLEAR_SCREEN);
+	send_to_all_panels(CMD_CLEAR_SCREEN, 0, 0);
 }
 
 void copy_matrix_column(MatrixColumn from, MatrixColumn to) {
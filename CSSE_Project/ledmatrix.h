@@ -17,6 +17,15 @@
 #define MATRIX_NUM_COLUMNS 16
 #define MATRIX_NUM_ROWS 8
 
+// Several matrices may be daisy chained on the SPI bus, each with its own
+// slave select line. They are arranged side by side, so panel p shows
+// columns p*16 to p*16+15 of the combined display. 1, 2 or 4 panels are
+// supported. (Can be overridden by defining it as a compiler symbol.)
+#ifndef LEDMATRIX_NUM_PANELS
+#define LEDMATRIX_NUM_PANELS 1
+#endif
+#define MATRIX_TOTAL_COLUMNS (MATRIX_NUM_COLUMNS * LEDMATRIX_NUM_PANELS)
+
 // Data types which can be used to store display information
 typedef PixelColour MatrixData[MATRIX_NUM_COLUMNS][MATRIX_NUM_ROWS];
 typedef PixelColour MatrixRow[MATRIX_NUM_COLUMNS];
@@ -27,7 +36,12 @@ typedef PixelColour MatrixColumn[MATRIX_NUM_ROWS];
 // below are used.
 void ledmatrix_setup(void);
 
-// Functions to update the display
+// Choose which panel the functions below send to. Panel 0 is selected
+// after ledmatrix_setup(). Invalid panel numbers are ignored.
+void ledmatrix_select_panel(uint8_t panel);
+
+// Functions to update the display (the selected panel only, except for the 
+// shift and clear functions which apply to every panel).
 // For those functions which take an x or a y value, the value must be valid
 // or the request will be ignored. (i.e. x must be < MATRIX_NUM_COLUMNS
 // and y must be < MATRIX_NUM_ROWS)
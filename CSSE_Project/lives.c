@@ -5,31 +5,26 @@
  */
 
 #include "lives.h"
-#include <avr/io.h>
 
-uint32_t lives;
+uint8_t lives;
+uint8_t lives_version;
 
 void init_lives(void) {
-	// Leave the joystick alone
-	PORTA &= (1 << 0) | (1 << 1);
-	for (int8_t i = 0; i < 4; i++) {
-		// Set the last four bits to the number of live -> 2^{lives}.
-		PORTA |= (1 << (4 + i));
-	}
-	lives = 4;
+	lives = MAX_LIVES;
+	lives_version++;
 }
 
-void add_to_lives(int16_t value) {
-	lives += value;
-	// Reset the last seven bits.
-	PORTA &= (1 << 0) | (1 << 1);
-	// Does the lights in the right order.
-	for (int8_t i = 1; i < lives + 1; i++) {
-		// Set the last four bits to the number of live -> 2^{lives}.
-		PORTA |= (1 << (7 - i));
+void add_to_lives(int8_t value) {
+	if(value) {
+		lives += value;
+		lives_version++;
 	}
 }
 
-uint32_t get_lives(void) {
+uint8_t get_lives(void) {
 	return lives;
 }
+
+uint8_t get_lives_version(void) {
+	return lives_version;
+}
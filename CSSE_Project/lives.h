@@ -9,8 +9,14 @@
 
 #include <stdint.h>
 
+#define MAX_LIVES 4
+
 void init_lives(void);
-void add_to_lives(int16_t value);
-uint32_t get_lives(void);
+void add_to_lives(int8_t value);
+uint8_t get_lives(void);
+
+// Changes every time the number of lives changes (see 
+// get_score_version() in score.h).
+uint8_t get_lives_version(void);
 
-#endif /* LIVES_H_ */
\ No newline at end of file
+#endif /* LIVES_H_ */
@@ -0,0 +1,337 @@
+/*
+ * lockstep.c
+ *
+ * Written by Matt Burton
+ */
+
+#include "lockstep.h"
+#include "serialio.h"
+#include "timer0.h"
+#include "log.h"
+
+// Packets sent over the link:
+//	PACKET_SYNC, type, payload, check
+// where the payload's length is fixed by the type (multi-byte values 
+// least significant byte first) and check is the exclusive or of the 
+// type and payload bytes (as remote.h's frames are checked). Bytes 
+// before a sync byte are skipped, and a packet whose check doesn't 
+// match is dropped - so other data on the line (e.g. telemetry from a
+// board which isn't in a game) can't be taken for an invitation.
+#define PACKET_SYNC		0x16	// ASCII SYN
+#define PACKET_START	'S'		// Invitation: seed (4 bytes), difficulty (2 bytes)
+#define PACKET_READY	'R'		// Invitation accepted
+#define PACKET_INPUT	'I'		// frame (2 bytes), input
+#define PACKET_CHECKSUM	'C'		// frame (2 bytes), checksum (2 bytes)
+#define MAX_PAYLOAD		6
+#define PACKET_BYTES(payload)	(3 + (payload))
+
+// While one board is held up (e.g. by the base hit animation) the other
+// can run LOCKSTEP_INPUT_DELAY more frames, so port 1's input buffer 
+// must hold that many input packets and a checksum packet.
+#if SERIAL1_INPUT_BUFFER_SIZE < LOCKSTEP_INPUT_DELAY * PACKET_BYTES(3) + PACKET_BYTES(4)
+#error "SERIAL1_INPUT_BUFFER_SIZE is too small for the link's packets"
+#endif
+
+// How often the host repeats its invitation
+#define INVITE_MS		250
+
+// Inputs are kept for BUFFER_FRAMES frames. The other board can be up
+// to 2 * LOCKSTEP_INPUT_DELAY frames ahead of us, so this must be at 
+// least that (and a power of two).
+#define BUFFER_FRAMES	8
+#define BUFFER_INDEX(f)	((f) & (BUFFER_FRAMES - 1))
+
+#if BUFFER_FRAMES < 2 * LOCKSTEP_INPUT_DELAY
+#error "BUFFER_FRAMES is too small for LOCKSTEP_INPUT_DELAY"
+#endif
+
+static uint8_t active;
+static uint8_t status;
+static uint8_t player;
+static uint32_t seed;
+static uint16_t difficulty;
+
+// frame - the next frame to run.
+// remote_frames - the other player's inputs have arrived for every 
+// frame before this one.
+// next_input - this player's input for the next frame we send.
+static uint16_t frame;
+static uint16_t remote_frames;
+static uint8_t local_inputs[BUFFER_FRAMES];
+static uint8_t remote_inputs[BUFFER_FRAMES];
+static uint8_t next_input;
+static uint32_t next_frame_time;
+static uint32_t last_receive_time;
+
+// The latest checksums from each board, and the frames they are for
+static uint8_t have_local_checksum;
+static uint16_t local_checksum_frame;
+static uint16_t local_checksum;
+static uint8_t have_remote_checksum;
+static uint16_t remote_checksum_frame;
+static uint16_t remote_checksum;
+
+// The packet being received. packet_type is 0 between packets, and
+// PACKET_SYNC once the sync byte has arrived but the type hasn't.
+static uint8_t packet_type;
+static uint8_t packet_length;
+static uint8_t packet_check;
+static uint8_t packet[MAX_PAYLOAD];
+
+static void start(uint8_t new_player, uint32_t new_seed, uint16_t new_difficulty);
+static void compare_checksums(void);
+static uint8_t payload_length(uint8_t type);
+static uint8_t receive_packet(void);
+static void send_packet(uint8_t type, const uint8_t* payload);
+static uint16_t packet_word(uint8_t offset);
+
+uint8_t lockstep_host(uint32_t new_seed, uint16_t new_difficulty) {
+	uint32_t start_time = get_current_time();
+	uint32_t invite_time = start_time;
+	uint8_t payload[6];
+	
+	clear_serial_port_input_buffer(LOCKSTEP_PORT);
+	serial_port_enable_output(LOCKSTEP_PORT, 1);
+	packet_type = 0;
+	payload[0] = (uint8_t)new_seed;
+	payload[1] = (uint8_t)(new_seed >> 8);
+	payload[2] = (uint8_t)(new_seed >> 16);
+	payload[3] = (uint8_t)(new_seed >> 24);
+	payload[4] = (uint8_t)new_difficulty;
+	payload[5] = (uint8_t)(new_difficulty >> 8);
+	while(get_current_time() < start_time + LOCKSTEP_TIMEOUT_MS) {
+		if(get_current_time() >= invite_time) {
+			send_packet(PACKET_START, payload);
+			invite_time += INVITE_MS;
+		}
+		if(receive_packet() == PACKET_READY) {
+			start(0, new_seed, new_difficulty);
+			return 1;
+		}
+	}
+	serial_port_enable_output(LOCKSTEP_PORT, 0);
+	return 0;
+}
+
+uint8_t lockstep_poll_join(void) {
+	uint8_t type;
+	
+	while((type = receive_packet()) != 0) {
+		if(type == PACKET_START) {
+			serial_port_enable_output(LOCKSTEP_PORT, 1);
+			send_packet(PACKET_READY, 0);
+			start(1, packet_word(0) | ((uint32_t)packet_word(2) << 16),
+					packet_word(4));
+			return 1;
+		}
+	}
+	return 0;
+}
+
+void lockstep_stop(void) {
+	active = 0;
+	clear_serial_port_input_buffer(LOCKSTEP_PORT);
+	serial_port_enable_output(LOCKSTEP_PORT, 0);
+}
+
+uint8_t lockstep_active(void) {
+	return active;
+}
+
+uint8_t lockstep_status(void) {
+	return status;
+}
+
+uint32_t lockstep_seed(void) {
+	return seed;
+}
+
+uint16_t lockstep_difficulty(void) {
+	return difficulty;
+}
+
+void lockstep_set_input(uint8_t input) {
+	if(input != INPUT_NONE) {
+		next_input = input;
+	}
+}
+
+uint8_t lockstep_next_frame(uint32_t current_time) {
+	uint8_t type;
+	uint16_t input_frame;
+	uint8_t payload[3];
+	
+	if(!active || status != LOCKSTEP_OK) {
+		return 0;
+	}
+	while((type = receive_packet()) != 0) {
+		last_receive_time = current_time;
+		if(type == PACKET_INPUT) {
+			// Inputs arrive in frame order - a gap means bytes were lost
+			if(packet_word(0) != remote_frames) {
+				LOG2(LOG_LEVEL_ERROR, LOG_LINK_GAP, packet_word(0), remote_frames);
+				status = LOCKSTEP_DESYNC;
+				return 0;
+			}
+			remote_inputs[BUFFER_INDEX(remote_frames)] = packet[2];
+			remote_frames++;
+		} else if(type == PACKET_CHECKSUM) {
+			remote_checksum_frame = packet_word(0);
+			remote_checksum = packet_word(2);
+			have_remote_checksum = 1;
+			compare_checksums();
+		}
+	}
+	if(current_time >= last_receive_time + LOCKSTEP_TIMEOUT_MS) {
+		LOG1(LOG_LEVEL_ERROR, LOG_LINK_LOST, frame);
+		status = LOCKSTEP_LINK_LOST;
+	}
+	if(status != LOCKSTEP_OK || current_time < next_frame_time || 
+			remote_frames == frame) {
+		return 0;
+	}
+	
+	// Send our input for LOCKSTEP_INPUT_DELAY frames from now. (Inputs 
+	// for the first few frames are all INPUT_NONE.)
+	input_frame = frame + LOCKSTEP_INPUT_DELAY;
+	local_inputs[BUFFER_INDEX(input_frame)] = next_input;
+	payload[0] = (uint8_t)input_frame;
+	payload[1] = (uint8_t)(input_frame >> 8);
+	payload[2] = next_input;
+	send_packet(PACKET_INPUT, payload);
+	next_input = INPUT_NONE;
+	
+	// If we've been held up waiting for the other board we don't try to
+	// catch up
+	next_frame_time += LOCKSTEP_FRAME_MS;
+	if(next_frame_time < current_time) {
+		next_frame_time = current_time;
+	}
+	return 1;
+}
+
+uint16_t lockstep_frame(void) {
+	return frame;
+}
+
+uint8_t lockstep_input(uint8_t input_player) {
+	if(input_player == player) {
+		return local_inputs[BUFFER_INDEX(frame)];
+	} else {
+		return remote_inputs[BUFFER_INDEX(frame)];
+	}
+}
+
+void lockstep_end_frame(uint16_t checksum) {
+	uint8_t payload[4];
+	
+	if(frame % LOCKSTEP_CHECKSUM_FRAMES == 0) {
+		local_checksum_frame = frame;
+		local_checksum = checksum;
+		have_local_checksum = 1;
+		payload[0] = (uint8_t)frame;
+		payload[1] = (uint8_t)(frame >> 8);
+		payload[2] = (uint8_t)checksum;
+		payload[3] = (uint8_t)(checksum >> 8);
+		send_packet(PACKET_CHECKSUM, payload);
+		compare_checksums();
+	}
+	frame++;
+}
+
+static void start(uint8_t new_player, uint32_t new_seed, uint16_t new_difficulty) {
+	active = 1;
+	status = LOCKSTEP_OK;
+	player = new_player;
+	seed = new_seed;
+	difficulty = new_difficulty;
+	frame = 0;
+	remote_frames = LOCKSTEP_INPUT_DELAY;
+	for(uint8_t i = 0; i < BUFFER_FRAMES; i++) {
+		local_inputs[i] = INPUT_NONE;
+		remote_inputs[i] = INPUT_NONE;
+	}
+	next_input = INPUT_NONE;
+	have_local_checksum = 0;
+	have_remote_checksum = 0;
+	next_frame_time = get_current_time();
+	last_receive_time = next_frame_time;
+	LOG1(LOG_LEVEL_INFO, LOG_TWO_PLAYER_START, new_player);
+}
+
+// The boards only swap a checksum every LOCKSTEP_CHECKSUM_FRAMES frames
+// and are never that far apart, so there is at most one pair to check.
+static void compare_checksums(void) {
+	if(have_local_checksum && have_remote_checksum && 
+			local_checksum_frame == remote_checksum_frame) {
+		if(local_checksum != remote_checksum) {
+			LOG1(LOG_LEVEL_ERROR, LOG_DESYNC, local_checksum_frame);
+			status = LOCKSTEP_DESYNC;
+		}
+		have_remote_checksum = 0;
+	}
+}
+
+// Returns the payload length of the given packet type, or 0xFF if it
+// isn't one.
+static uint8_t payload_length(uint8_t type) {
+	switch(type) {
+		case PACKET_START:		return 6;
+		case PACKET_READY:		return 0;
+		case PACKET_INPUT:		return 3;
+		case PACKET_CHECKSUM:	return 4;
+		default:				return 0xFF;
+	}
+}
+
+// Read bytes from the other board until a whole packet has arrived, and return
+// its type (the payload is in packet[]). Returns 0 if there isn't a 
+// whole packet yet.
+static uint8_t receive_packet(void) {
+	int16_t byte;
+	uint8_t type;
+	
+	while((byte = serial_read_raw(LOCKSTEP_PORT)) != -1) {
+		if(packet_type == 0 || packet_type == PACKET_SYNC) {
+			// Looking for a sync byte, then a packet type
+			if(packet_type == PACKET_SYNC && payload_length(byte) != 0xFF) {
+				packet_type = byte;
+				packet_length = 0;
+				packet_check = byte;
+			} else {
+				packet_type = (byte == PACKET_SYNC) ? PACKET_SYNC : 0;
+			}
+		} else if(packet_length < payload_length(packet_type)) {
+			packet[packet_length++] = byte;
+			packet_check ^= byte;
+		} else {
+			// The check byte
+			type = packet_type;
+			packet_type = 0;
+			if(byte == packet_check) {
+				return type;
+			}
+		}
+	}
+	return 0;
+}
+
+// A packet is dropped whole if there isn't room for it
+static void send_packet(uint8_t type, const uint8_t* payload) {
+	uint8_t bytes[PACKET_BYTES(MAX_PAYLOAD)];
+	uint8_t length = payload_length(type);
+	uint8_t check = type;
+	
+	bytes[0] = PACKET_SYNC;
+	bytes[1] = type;
+	for(uint8_t i = 0; i < length; i++) {
+		bytes[2 + i] = payload[i];
+		check ^= payload[i];
+	}
+	bytes[2 + length] = check;
+	(void)serial_write_raw(LOCKSTEP_PORT, bytes, PACKET_BYTES(length));
+}
+
+static uint16_t packet_word(uint8_t offset) {
+	return packet[offset] | ((uint16_t)packet[offset + 1] << 8);
+}
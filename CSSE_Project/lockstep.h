@@ -0,0 +1,82 @@
+/*
+ * lockstep.h
+ *
+ * Author: Matt Burton
+ *
+ * Two player (co-operative) mode over a serial link between two boards
+ * (serial port 1). Both boards run the same game - the same random seed
+ * and the same inputs give the same result - so the only thing sent 
+ * each frame is the player's input, a few bytes, never the game state.
+ *
+ * The game runs in frames of LOCKSTEP_FRAME_MS. A player's input is 
+ * applied LOCKSTEP_INPUT_DELAY frames after it was made, which gives it
+ * time to reach the other board. A board can only run a frame once it 
+ * has the other player's input for it, so neither board gets more than
+ * a few frames ahead. Every LOCKSTEP_CHECKSUM_FRAMES frames the boards
+ * also swap a checksum of the game state, so that any difference 
+ * between them (a desync) is found.
+ *
+ * One board hosts (lockstep_host()) and the other joins when it sees
+ * the host's invitation (lockstep_poll_join()). The host picks the 
+ * random seed and the difficulty, and is player 0. Each frame player 0's input is applied
+ * first, then player 1's - both steer the one base station.
+ *
+ * Port 1's transmitter is only turned on while hosting or playing (see
+ * telemetry.h for why), and turned off again by lockstep_stop().
+ */
+
+#ifndef LOCKSTEP_H_
+#define LOCKSTEP_H_
+
+#include <stdint.h>
+#include "serialio.h"
+
+#define LOCKSTEP_PORT				SERIAL_PORT1
+#define LOCKSTEP_PLAYERS			2
+#define LOCKSTEP_FRAME_MS			50
+#define LOCKSTEP_INPUT_DELAY		3
+#define LOCKSTEP_CHECKSUM_FRAMES	16
+// Give up if nothing arrives from the other board for this long
+#define LOCKSTEP_TIMEOUT_MS			2000
+
+// Player inputs
+#define INPUT_NONE	0
+#define INPUT_LEFT	1
+#define INPUT_RIGHT	2
+#define INPUT_FIRE	3
+
+// Values returned by lockstep_status()
+#define LOCKSTEP_OK			0
+#define LOCKSTEP_LINK_LOST	1
+#define LOCKSTEP_DESYNC		2
+
+// Invite the other board to a game (played at the given difficulty - 
+// see PARAM_DIFFICULTY), waiting up to LOCKSTEP_TIMEOUT_MS for it to 
+// accept. Returns 1 (and starts two player mode) if it did, 0 otherwise.
+uint8_t lockstep_host(uint32_t seed, uint16_t difficulty);
+
+// Check for an invitation from the other board, and accept it if there
+// is one. Returns 1 if two player mode has started, 0 otherwise.
+uint8_t lockstep_poll_join(void);
+
+// Leave two player mode.
+void lockstep_stop(void);
+
+uint8_t lockstep_active(void);
+uint8_t lockstep_status(void);
+uint32_t lockstep_seed(void);
+uint16_t lockstep_difficulty(void);
+
+// Set this player's input for the next frame. (Only the last input
+// given before the frame starts counts.)
+void lockstep_set_input(uint8_t input);
+
+// Returns 1 if it is time for the next frame and the other player's 
+// input for it has arrived. The caller then applies lockstep_input()
+// for each player, runs the frame and calls lockstep_end_frame().
+uint8_t lockstep_next_frame(uint32_t current_time);
+uint16_t lockstep_frame(void);
+uint8_t lockstep_input(uint8_t player);
+void lockstep_end_frame(uint16_t checksum);
+
+#endif /* LOCKSTEP_H_ */
@@ -0,0 +1,28 @@
+/*
+ * log.c
+ *
+ * Written by Matt Burton
+ */
+
+#include "log.h"
+#include "telemetry.h"
+
+static uint16_t dropped;
+
+void log_write(uint8_t id, uint8_t num_args, uint16_t a, uint16_t b) {
+	uint8_t record[6];
+	
+	record[0] = LOG_MARKER;
+	record[1] = id;
+	record[2] = (uint8_t)a;
+	record[3] = (uint8_t)(a >> 8);
+	record[4] = (uint8_t)b;
+	record[5] = (uint8_t)(b >> 8);
+	if(!telemetry_write(record, 2 + 2 * num_args)) {
+		dropped++;
+	}
+}
+
+uint16_t log_dropped(void) {
+	return dropped;
+}
@@ -0,0 +1,64 @@
+/*
+ * log.h
+ *
+ * Author: Matt Burton
+ *
+ * Diagnostic logging without formatting on the board. Each log call 
+ * sends a short binary record - LOG_MARKER, the message ID and the
+ * arguments (16 bits each, least significant byte first) - and a tool 
+ * on the host turns it into text using the format strings in 
+ * log_ids.h. Records are sent on the telemetry port (see telemetry.h)
+ * and never wait: if they can't be sent straight away they are dropped
+ * (and counted).
+ *
+ * Each message has a level. Calls below LOG_LEVEL (which can be set as
+ * a compiler symbol) are removed at compile time, arguments and all.
+ */
+
+#ifndef LOG_H_
+#define LOG_H_
+
+#include <stdint.h>
+
+#define LOG_MARKER		0x1F
+
+#define LOG_LEVEL_DEBUG	0
+#define LOG_LEVEL_INFO	1
+#define LOG_LEVEL_ERROR	2
+#define LOG_LEVEL_NONE	3
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL		LOG_LEVEL_INFO
+#endif
+
+// Message IDs
+#define LOG_MESSAGE(id, format)	id,
+enum {
+#include "log_ids.h"
+	NUM_LOG_MESSAGES
+};
+#undef LOG_MESSAGE
+
+// Log a message with no, one or two arguments
+#define LOG(level, id) do {									\
+			if((level) >= LOG_LEVEL) {						\
+				log_write(id, 0, 0, 0);						\
+			}												\
+		} while(0)
+#define LOG1(level, id, a) do {								\
+			if((level) >= LOG_LEVEL) {						\
+				log_write(id, 1, a, 0);						\
+			}												\
+		} while(0)
+#define LOG2(level, id, a, b) do {							\
+			if((level) >= LOG_LEVEL) {						\
+				log_write(id, 2, a, b);						\
+			}												\
+		} while(0)
+
+void log_write(uint8_t id, uint8_t num_args, uint16_t a, uint16_t b);
+
+// The number of records dropped because the output buffer was full
+uint16_t log_dropped(void);
+
+#endif /* LOG_H_ */
@@ -0,0 +1,31 @@
+/*
+ * log_ids.h
+ *
+ * Author: Matt Burton
+ *
+ * The list of log messages (see log.h). Each LOG_MESSAGE() gives the
+ * message's ID and its format string, whose % conversions take the
+ * message's arguments in order (each argument is 16 bits). The board
+ * only uses the IDs - the format strings are never compiled into it. A
+ * host tool includes this file with its own definition of LOG_MESSAGE 
+ * to get the table of format strings, for example
+ *
+ *	#define LOG_MESSAGE(id, format) [id] = format,
+ *	static const char* formats[] = {
+ *	#include "log_ids.h"
+ *	};
+ *
+ * IDs must never be reused for a different message (add new ones at
+ * the end).
+ */
+
+LOG_MESSAGE(LOG_GAME_START,			"game started")
+LOG_MESSAGE(LOG_GAME_OVER,			"game over: score %u after %u ticks")
+LOG_MESSAGE(LOG_TWO_PLAYER_START,	"two player game started as player %u")
+LOG_MESSAGE(LOG_DESYNC,				"out of step with the other board at frame %u")
+LOG_MESSAGE(LOG_LINK_LOST,			"lost contact with the other board at frame %u")
+LOG_MESSAGE(LOG_LINK_GAP,			"input for frame %u arrived, expected frame %u")
+LOG_MESSAGE(LOG_REMOTE_BAD_CHECK,	"remote control frame %u failed its check")
+LOG_MESSAGE(LOG_PARAM_SET,			"parameter %u set to %u")
+LOG_MESSAGE(LOG_PARAMS_SAVED,		"parameters saved")
+LOG_MESSAGE(LOG_AUTOPILOT_PRESSES,	"autopilot pushed %u buttons")
@@ -0,0 +1,75 @@
+/*
+ * orientation.c
+ *
+ * Written by Matt Burton
+ *
+ * The game to LED matrix mapping tables. Everything here is evaluated
+ * by the compiler - the tables are constants in program memory.
+ */
+
+#include "orientation.h"
+
+#define WIDTH	ORIENTATION_FIELD_WIDTH
+#define COLUMNS	MATRIX_TOTAL_COLUMNS
+#define ROWS	MATRIX_NUM_ROWS
+
+// With the panels turned, each panel shows ROWS game columns. These give
+// the first matrix column of the panel showing game column gx, and the
+// place of gx across that panel.
+#define PANEL_X(gx)	(VIEW_X(gx) / ROWS * MATRIX_NUM_COLUMNS)
+#define ACROSS(gx)	(VIEW_X(gx) % ROWS)
+
+// Flip the game x value first if the display is mirrored
+#if DISPLAY_MIRRORED
+#define VIEW_X(gx)	(WIDTH - 1 - (gx))
+#else
+#define VIEW_X(gx)	(gx)
+#endif
+
+// The part of the matrix address that each game axis determines
+#if DISPLAY_ORIENTATION == 0
+#define X_PART(gx)	MATRIX_ADDRESS(VIEW_X(gx), 0)
+#define Y_PART(gy)	MATRIX_ADDRESS(0, gy)
+#elif DISPLAY_ORIENTATION == 90
+#define X_PART(gx)	MATRIX_ADDRESS(PANEL_X(gx), ROWS - 1 - ACROSS(gx))
+#define Y_PART(gy)	MATRIX_ADDRESS(gy, 0)
+#elif DISPLAY_ORIENTATION == 180
+#define X_PART(gx)	MATRIX_ADDRESS(COLUMNS - 1 - VIEW_X(gx), 0)
+#define Y_PART(gy)	MATRIX_ADDRESS(0, 7 - (gy))
+#else
+#define X_PART(gx)	MATRIX_ADDRESS(PANEL_X(gx), ACROSS(gx))
+#define Y_PART(gy)	MATRIX_ADDRESS(MATRIX_NUM_COLUMNS - 1 - (gy), 0)
+#endif
+
+// Eight consecutive entries. Both field dimensions are multiples of 8.
+#define AXIS_8(part, n) \
+		part((n) + 0), part((n) + 1), part((n) + 2), part((n) + 3), \
+		part((n) + 4), part((n) + 5), part((n) + 6), part((n) + 7)
+
+const uint16_t game_x_to_matrix[ORIENTATION_FIELD_WIDTH] PROGMEM = {
+	AXIS_8(X_PART, 0)
+#if ORIENTATION_FIELD_WIDTH > 8
+	, AXIS_8(X_PART, 8)
+#endif
+#if ORIENTATION_FIELD_WIDTH > 16
+	, AXIS_8(X_PART, 16), AXIS_8(X_PART, 24)
+#endif
+#if ORIENTATION_FIELD_WIDTH > 32
+	, AXIS_8(X_PART, 32), AXIS_8(X_PART, 40)
+	, AXIS_8(X_PART, 48), AXIS_8(X_PART, 56)
+#endif
+};
+
+const uint16_t game_y_to_matrix[ORIENTATION_FIELD_HEIGHT] PROGMEM = {
+	AXIS_8(Y_PART, 0)
+#if ORIENTATION_FIELD_HEIGHT > 8
+	, AXIS_8(Y_PART, 8)
+#endif
+#if ORIENTATION_FIELD_HEIGHT > 16
+	, AXIS_8(Y_PART, 16), AXIS_8(Y_PART, 24)
+#endif
+#if ORIENTATION_FIELD_HEIGHT > 32
+	, AXIS_8(Y_PART, 32), AXIS_8(Y_PART, 40)
+	, AXIS_8(Y_PART, 48), AXIS_8(Y_PART, 56)
+#endif
+};
@@ -0,0 +1,117 @@
+/*
+ * orientation.h
+ *
+ * Author: Matt Burton
+ *
+ * Build time setting for how the LED matrix panels are mounted relative
+ * to the player. The mapping from game positions to matrix addresses is
+ * generated at compile time as two small tables in program memory (one
+ * per game axis), so any orientation costs two table lookups per pixel.
+ *
+ * DISPLAY_ORIENTATION is the clockwise rotation (0, 90, 180 or 270) of
+ * the game field relative to the panels as marked. Extra panels always
+ * make the field wider. With 0 or 180 the panels sit side by side along
+ * the matrix x axis (see ledmatrix.h) and the field is 16 columns wide 
+ * per panel and 8 rows high. With 90 or 270 each panel is turned on its
+ * own and they sit side by side across the field (panel 0 on the left,
+ * as seen by the player, unless mirrored), so the field is 8 columns 
+ * wide per panel and 16 rows high.
+ * If DISPLAY_MIRRORED is 1 the field is also flipped left to right (as
+ * seen by the player). Both can be overridden by defining them as
+ * compiler symbols. The default is the original layout - the board
+ * turned so that its x axis runs up the field.
+ */
+
+#ifndef ORIENTATION_H_
+#define ORIENTATION_H_
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+#include "ledmatrix.h"
+
+#ifndef DISPLAY_ORIENTATION
+#define DISPLAY_ORIENTATION 90
+#endif
+
+#ifndef DISPLAY_MIRRORED
+#define DISPLAY_MIRRORED 0
+#endif
+
+#if DISPLAY_ORIENTATION == 0 || DISPLAY_ORIENTATION == 180
+#define ORIENTATION_FIELD_WIDTH MATRIX_TOTAL_COLUMNS
+#define ORIENTATION_FIELD_HEIGHT MATRIX_NUM_ROWS
+#elif DISPLAY_ORIENTATION == 90 || DISPLAY_ORIENTATION == 270
+#define ORIENTATION_FIELD_WIDTH (MATRIX_NUM_ROWS * LEDMATRIX_NUM_PANELS)
+#define ORIENTATION_FIELD_HEIGHT MATRIX_NUM_COLUMNS
+#else
+#error "DISPLAY_ORIENTATION must be 0, 90, 180 or 270"
+#endif
+
+// A pixel on the combined display of all panels - x (0 to 
+// MATRIX_TOTAL_COLUMNS - 1) in the low byte, y (0 to 7) in the high byte.
+#define MATRIX_ADDRESS(x, y)		((uint16_t)(((uint16_t)(y) << 8) | (x)))
+#define MATRIX_ADDRESS_X(addr)		((uint8_t)(addr))
+#define MATRIX_ADDRESS_Y(addr)		((uint8_t)((addr) >> 8))
+#define INVALID_MATRIX_ADDRESS		0xFFFF
+
+// Each entry holds the part of the matrix address determined by that 
+// game axis. OR-ing the entries for a game x and y gives the address.
+extern const uint16_t game_x_to_matrix[ORIENTATION_FIELD_WIDTH];
+extern const uint16_t game_y_to_matrix[ORIENTATION_FIELD_HEIGHT];
+
+// Game x and y values are assumed to be on the field.
+#define MATRIX_ADDRESS_FROM_GAME_XY(gameX, gameY) \
+		(pgm_read_word(&game_x_to_matrix[gameX]) | \
+		pgm_read_word(&game_y_to_matrix[gameY]))
+
+// The change in matrix address from one game column to the next (to
+// the right), as a uint16_t to add to an address. Moving along a row of
+// the field steps along a matrix row or column, one pixel at a time, 
+// for runs of ORIENTATION_RUN_COLUMNS game columns (from game column 0
+// of the display) - i.e. up to the edge of a panel when it is turned.
+#if DISPLAY_ORIENTATION == 0 || DISPLAY_ORIENTATION == 180
+#define GAME_X_STEP		MATRIX_ADDRESS(1, 0)
+#define ORIENTATION_RUN_COLUMNS		ORIENTATION_FIELD_WIDTH
+#else
+#define GAME_X_STEP		MATRIX_ADDRESS(0, 1)
+#define ORIENTATION_RUN_COLUMNS		MATRIX_NUM_ROWS
+#endif
+#if (DISPLAY_ORIENTATION == 0 || DISPLAY_ORIENTATION == 270) != (DISPLAY_MIRRORED != 0)
+#define ORIENTATION_GAME_X_STEP		GAME_X_STEP
+#else
+#define ORIENTATION_GAME_X_STEP		((uint16_t)-GAME_X_STEP)
+#endif
+
+// The framebuffer_shift() direction (see framebuffer.h) which moves
+// everything on the display one game column to the left (towards game
+// x = 0), and the one which moves it one column to the right.
+#if (DISPLAY_ORIENTATION == 0) != (DISPLAY_MIRRORED != 0) && \
+		(DISPLAY_ORIENTATION == 0 || DISPLAY_ORIENTATION == 180)
+#define ORIENTATION_SHIFT_GAME_LEFT		SHIFT_LEFT
+#define ORIENTATION_SHIFT_GAME_RIGHT	SHIFT_RIGHT
+#elif DISPLAY_ORIENTATION == 0 || DISPLAY_ORIENTATION == 180
+#define ORIENTATION_SHIFT_GAME_LEFT		SHIFT_RIGHT
+#define ORIENTATION_SHIFT_GAME_RIGHT	SHIFT_LEFT
+#elif (DISPLAY_ORIENTATION == 90) != (DISPLAY_MIRRORED != 0)
+#define ORIENTATION_SHIFT_GAME_LEFT		SHIFT_UP
+#define ORIENTATION_SHIFT_GAME_RIGHT	SHIFT_DOWN
+#else
+#define ORIENTATION_SHIFT_GAME_LEFT		SHIFT_DOWN
+#define ORIENTATION_SHIFT_GAME_RIGHT	SHIFT_UP
+#endif
+
+// When the panels are turned, a game row runs from one panel on to the
+// next, so framebuffer_shift() carries the row that SHIFT_UP pushes off 
+// the top of a panel on to the bottom of the panel before it in the 
+// chain (90), or the one after (270) - and the other way for SHIFT_DOWN.
+// This is the chain offset of the panel the row shifted in comes from, 
+// or 0 if each panel's rows stand alone.
+#if DISPLAY_ORIENTATION == 90
+#define ORIENTATION_SHIFT_UP_CARRY		1
+#elif DISPLAY_ORIENTATION == 270
+#define ORIENTATION_SHIFT_UP_CARRY		(-1)
+#else
+#define ORIENTATION_SHIFT_UP_CARRY		0
+#endif
+
+#endif /* ORIENTATION_H_ */
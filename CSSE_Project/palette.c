@@ -0,0 +1,133 @@
+/*
+ * palette.c
+ *
+ * Written by Matt Burton
+ */
+
+#include "palette.h"
+#include "framebuffer.h"
+#include <avr/pgmspace.h>
+
+/* Gamma corrected brightness table. gamma_table[level][value] gives the
+ * 4 bit channel value to output for a 4 bit channel value at the given
+ * brightness level. (value * (level/15)^2.2, rounded up so that
+ * anything lit stays lit until the level reaches 0.)
+ */
+static const uint8_t gamma_table[BRIGHTNESS_MAX + 1][16] PROGMEM = {
+	{ 0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0},
+	{ 0,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1},
+	{ 0,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1},
+	{ 0,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1},
+	{ 0,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1},
+	{ 0,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  2,  2,  2,  2},
+	{ 0,  1,  1,  1,  1,  1,  1,  1,  2,  2,  2,  2,  2,  2,  2,  2},
+	{ 0,  1,  1,  1,  1,  1,  2,  2,  2,  2,  2,  3,  3,  3,  3,  3},
+	{ 0,  1,  1,  1,  2,  2,  2,  2,  3,  3,  3,  3,  4,  4,  4,  4},
+	{ 0,  1,  1,  1,  2,  2,  2,  3,  3,  3,  4,  4,  4,  5,  5,  5},
+	{ 0,  1,  1,  2,  2,  3,  3,  3,  4,  4,  5,  5,  5,  6,  6,  7},
+	{ 0,  1,  2,  2,  3,  3,  4,  4,  5,  5,  6,  6,  7,  7,  8,  8},
+	{ 0,  1,  2,  2,  3,  4,  4,  5,  5,  6,  7,  7,  8,  8,  9, 10},
+	{ 0,  1,  2,  3,  3,  4,  5,  6,  6,  7,  8,  9,  9, 10, 11, 11},
+	{ 0,  1,  2,  3,  4,  5,  6,  7,  7,  8,  9, 10, 11, 12, 13, 13},
+	{ 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15}
+};
+
+static uint8_t global_level;
+static uint8_t layer_level[NUM_LAYERS];
+// The combination of the global and layer levels - used for each pixel
+static uint8_t effective_level[NUM_LAYERS];
+
+// Fade state. fade_step_time is 0 when no fade is in progress.
+static uint8_t fade_target;
+static uint16_t fade_step_time;
+static uint32_t last_fade_time;
+
+static void update_layer(uint8_t layer) {
+	uint8_t level = (global_level * layer_level[layer] + BRIGHTNESS_MAX / 2)
+			/ BRIGHTNESS_MAX;
+	if(level != effective_level[layer]) {
+		effective_level[layer] = level;
+		framebuffer_refresh_layer(layer);
+	}
+}
+
+void init_palette(void) {
+	global_level = BRIGHTNESS_MAX;
+	for(uint8_t i = 0; i < NUM_LAYERS; i++) {
+		layer_level[i] = BRIGHTNESS_MAX;
+		update_layer(i);
+	}
+	fade_step_time = 0;
+}
+
+void palette_set_brightness(uint8_t level) {
+	if(level > BRIGHTNESS_MAX) {
+		level = BRIGHTNESS_MAX;
+	}
+	global_level = level;
+	for(uint8_t i = 0; i < NUM_LAYERS; i++) {
+		update_layer(i);
+	}
+}
+
+void palette_set_layer_brightness(uint8_t layer, uint8_t level) {
+	if(layer >= NUM_LAYERS) {
+		return;
+	}
+	if(level > BRIGHTNESS_MAX) {
+		level = BRIGHTNESS_MAX;
+	}
+	layer_level[layer] = level;
+	update_layer(layer);
+}
+
+uint8_t palette_get_brightness(void) {
+	return global_level;
+}
+
+void palette_fade_to(uint8_t target, uint16_t step_ms) {
+	if(target > BRIGHTNESS_MAX) {
+		target = BRIGHTNESS_MAX;
+	}
+	fade_target = target;
+	// A step time of 0 would look like no fade - use 1ms instead
+	fade_step_time = step_ms ? step_ms : 1;
+	last_fade_time = 0;
+}
+
+uint8_t palette_fading(void) {
+	return fade_step_time != 0;
+}
+
+void palette_step(uint32_t current_time) {
+	if(!fade_step_time) {
+		return;
+	}
+	if(last_fade_time == 0) {
+		// First step of this fade - start timing from now
+		last_fade_time = current_time;
+		return;
+	}
+	if(current_time < last_fade_time + fade_step_time) {
+		return;
+	}
+	last_fade_time = current_time;
+	if(global_level < fade_target) {
+		palette_set_brightness(global_level + 1);
+	} else if(global_level > fade_target) {
+		palette_set_brightness(global_level - 1);
+	}
+	if(global_level == fade_target) {
+		fade_step_time = 0;
+	}
+}
+
+PixelColour palette_apply(PixelColour colour, uint8_t layer) {
+	uint8_t level = effective_level[layer];
+	if(level == BRIGHTNESS_MAX) {
+		return colour;
+	}
+	// Green is in the high 4 bits, red in the low 4 bits
+	return (pgm_read_byte(&gamma_table[level][colour >> 4]) << 4) |
+			pgm_read_byte(&gamma_table[level][colour & 0x0F]);
+}
@@ -0,0 +1,55 @@
+/*
+ * palette.h
+ *
+ * Author: Matt Burton
+ *
+ * Brightness control for the LED matrix. Colours in the framebuffer are
+ * stored at full brightness and every pixel belongs to a layer. When the
+ * framebuffer is flushed each colour is scaled by the global brightness
+ * and the brightness of its layer, using a gamma corrected lookup table
+ * so that each brightness step looks like an even change.
+ * Changing a brightness only marks the lit pixels on the affected layers
+ * as dirty, so a fade step costs one update per game row that has 
+ * something on it.
+ */
+
+#ifndef PALETTE_H_
+#define PALETTE_H_
+
+#include <stdint.h>
+#include "pixel_colour.h"
+
+// Brightness levels range from 0 (off) to BRIGHTNESS_MAX (as drawn)
+#define BRIGHTNESS_MAX 15
+
+// Layers that pixels can be drawn on (see framebuffer_select_layer())
+#define NUM_LAYERS		3
+#define LAYER_FIELD		0
+#define LAYER_BASE		1
+#define LAYER_EFFECTS	2
+
+// Set all brightness levels to BRIGHTNESS_MAX and stop any fade.
+void init_palette(void);
+
+// Set the global brightness or the brightness of a single layer.
+// Values greater than BRIGHTNESS_MAX are treated as BRIGHTNESS_MAX.
+void palette_set_brightness(uint8_t level);
+void palette_set_layer_brightness(uint8_t layer, uint8_t level);
+uint8_t palette_get_brightness(void);
+
+// Start fading the global brightness towards target, moving one level
+// every step_ms milliseconds. The fade is performed by palette_step().
+void palette_fade_to(uint8_t target, uint16_t step_ms);
+
+// Returns 1 if a fade is in progress, 0 otherwise.
+uint8_t palette_fading(void);
+
+// Advance any fade in progress. Should be called regularly from the
+// main loop (in the same way as display_data()).
+void palette_step(uint32_t current_time);
+
+// Return the colour to be sent to the LED matrix for the given colour
+// drawn on the given layer.
+PixelColour palette_apply(PixelColour colour, uint8_t layer);
+
+#endif /* PALETTE_H_ */
@@ -0,0 +1,150 @@
+/*
+ * params.c
+ *
+ * Written by Matt Burton
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <avr/pgmspace.h>
+#include <avr/eeprom.h>
+
+#include "params.h"
+
+// Parameter flags
+#define PARAM_RESTART	0x01	// New values take effect after a reset
+
+typedef struct {
+	PGM_P name;
+	uint8_t type;
+	uint8_t flags;
+	uint16_t min;
+	uint16_t max;
+	uint16_t default_value;
+} ParamInfo;
+
+static const char projectile_ms_name[] PROGMEM = "proj_ms";
+static const char joystick_ms_name[] PROGMEM = "joy_ms";
+static const char difficulty_name[] PROGMEM = "difficulty";
+static const char sound_name[] PROGMEM = "sound";
+static const char baud_name[] PROGMEM = "baud";
+static const char telemetry_name[] PROGMEM = "telemetry";
+
+static const ParamInfo param_info[NUM_PARAMS] PROGMEM = {
+	{projectile_ms_name,	PARAM_TYPE_NUMBER,	0,				50,		1000,	200},
+	{joystick_ms_name,		PARAM_TYPE_NUMBER,	0,				10,		500,	50},
+	{difficulty_name,		PARAM_TYPE_NUMBER,	0,				50,		400,	100},
+	{sound_name,			PARAM_TYPE_ON_OFF,	0,				0,		1,		1},
+	{baud_name,				PARAM_TYPE_NUMBER,	PARAM_RESTART,	2400,	38400,	19200},
+	{telemetry_name,		PARAM_TYPE_ON_OFF,	0,				0,		1,		0}
+};
+
+// The saved parameters. The magic number changes whenever the table
+// above changes, so that old saves are ignored. check is the sum of 
+// the value bytes.
+#define SAVE_MAGIC	0xA2
+typedef struct {
+	uint8_t magic;
+	uint16_t values[NUM_PARAMS];
+	uint8_t check;
+} SavedParams;
+static SavedParams EEMEM saved_params;
+
+static uint16_t values[NUM_PARAMS];
+
+// The bytes being saved, and how many have been written
+static SavedParams save_data;
+static uint8_t save_position = sizeof(SavedParams);
+
+static uint8_t values_check(const uint16_t* param_values);
+
+void init_params(void) {
+	SavedParams saved;
+	
+	params_set_defaults();
+	eeprom_read_block(&saved, &saved_params, sizeof(saved));
+	if(saved.magic != SAVE_MAGIC || saved.check != values_check(saved.values)) {
+		return;
+	}
+	for(uint8_t i = 0; i < NUM_PARAMS; i++) {
+		// Anything out of range is left at the default
+		(void)param_set(i, saved.values[i]);
+	}
+}
+
+uint16_t param_get(uint8_t param) {
+	return values[param];
+}
+
+uint8_t param_set(uint8_t param, uint16_t value) {
+	if(param >= NUM_PARAMS || value < pgm_read_word(&param_info[param].min) ||
+			value > pgm_read_word(&param_info[param].max)) {
+		return 0;
+	}
+	values[param] = value;
+	return 1;
+}
+
+int8_t param_find(const char* name) {
+	for(uint8_t i = 0; i < NUM_PARAMS; i++) {
+		if(strcmp_P(name, (PGM_P)pgm_read_ptr(&param_info[i].name)) == 0) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+uint8_t param_type(uint8_t param) {
+	return pgm_read_byte(&param_info[param].type);
+}
+
+void param_print(uint8_t param) {
+	printf_P((PGM_P)pgm_read_ptr(&param_info[param].name));
+	if(param_type(param) == PARAM_TYPE_ON_OFF) {
+		printf_P(values[param] ? PSTR(" = on") : PSTR(" = off"));
+	} else {
+		printf_P(PSTR(" = %u (%u to %u)"), values[param], 
+				pgm_read_word(&param_info[param].min), 
+				pgm_read_word(&param_info[param].max));
+	}
+	if(pgm_read_byte(&param_info[param].flags) & PARAM_RESTART) {
+		printf_P(PSTR(" after reset"));
+	}
+}
+
+void params_set_defaults(void) {
+	for(uint8_t i = 0; i < NUM_PARAMS; i++) {
+		values[i] = pgm_read_word(&param_info[i].default_value);
+	}
+}
+
+void params_save(void) {
+	save_data.magic = SAVE_MAGIC;
+	for(uint8_t i = 0; i < NUM_PARAMS; i++) {
+		save_data.values[i] = values[i];
+	}
+	save_data.check = values_check(values);
+	save_position = 0;
+}
+
+void params_save_step(void) {
+	if(save_position < sizeof(SavedParams) && eeprom_is_ready()) {
+		// Only bytes which have changed are actually written
+		eeprom_update_byte((uint8_t*)&saved_params + save_position,
+				((uint8_t*)&save_data)[save_position]);
+		save_position++;
+	}
+}
+
+uint8_t params_saving(void) {
+	return save_position < sizeof(SavedParams);
+}
+
+static uint8_t values_check(const uint16_t* param_values) {
+	uint8_t check = 0;
+	
+	for(uint8_t i = 0; i < NUM_PARAMS; i++) {
+		check += (uint8_t)param_values[i] + (uint8_t)(param_values[i] >> 8);
+	}
+	return check;
+}
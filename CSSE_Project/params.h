@@ -0,0 +1,61 @@
+/*
+ * params.h
+ *
+ * Author: Matt Burton
+ *
+ * Settings which can be changed while the game is running (from the 
+ * serial command shell - see shell.h) instead of by reflashing. Each
+ * parameter has a name, a type and a range, listed in a table in 
+ * program memory. Values are kept in RAM and can be saved to EEPROM, 
+ * from where they are loaded at power up.
+ */
+
+#ifndef PARAMS_H_
+#define PARAMS_H_
+
+#include <stdint.h>
+
+// Parameter numbers
+#define PARAM_PROJECTILE_MS		0	// Time between projectile moves
+#define PARAM_JOYSTICK_MS		1	// Time between joystick readings
+#define PARAM_DIFFICULTY		2	// Starting asteroid speed, percent
+#define PARAM_SOUND				3	// Sound effects on or off
+#define PARAM_BAUD				4	// Serial port 0 baud rate
+#define PARAM_TELEMETRY			5	// Telemetry output on or off
+#define NUM_PARAMS				6
+
+// Parameter types
+#define PARAM_TYPE_NUMBER		0
+#define PARAM_TYPE_ON_OFF		1
+
+// Set the parameters to their saved values (or the defaults if nothing
+// valid has been saved).
+void init_params(void);
+
+uint16_t param_get(uint8_t param);
+
+// Set a parameter. Returns 0 (and leaves it unchanged) if the value is
+// out of range, 1 otherwise.
+uint8_t param_set(uint8_t param, uint16_t value);
+
+// Returns the number of the parameter with the given name, or -1 if 
+// there isn't one.
+int8_t param_find(const char* name);
+
+uint8_t param_type(uint8_t param);
+
+// Print "name = value" for a parameter, with its range (and a note if a
+// new value only takes effect after a reset).
+void param_print(uint8_t param);
+
+void params_set_defaults(void);
+
+// Save all the parameters to EEPROM. Saving is done a byte at a time 
+// (each byte takes a few milliseconds to write), by params_save_step(),
+// which is called every time through the main loop and never waits.
+// params_saving() returns 1 until the save is complete.
+void params_save(void);
+void params_save_step(void);
+uint8_t params_saving(void);
+
+#endif /* PARAMS_H_ */
@@ -0,0 +1,135 @@
+/*
+ * particles.c
+ *
+ * Written by Matt Burton
+ */
+
+#include "particles.h"
+#include "framebuffer.h"
+#include "palette.h"
+#include "game.h"
+#include <avr/pgmspace.h>
+
+// How many frames a particle lives for
+#define PARTICLE_LIFETIME 6
+
+// Fixed point helpers - 8 bits of fraction, so 256 is one cell
+#define TO_FIXED(cell)		((int16_t)(cell) << 8)
+#define TO_CELL(fixed)		((int8_t)((fixed) >> 8))
+#define FIXED_HALF			128
+
+/* Velocities (in 1/256ths of a cell per frame) of the particles in
+ * a burst - eight directions at just under half a cell per frame.
+ */
+#define PARTICLES_PER_BURST 8
+static const int8_t burst_dx[PARTICLES_PER_BURST] PROGMEM = 
+		{0, 81, 115, 81, 0, -81, -115, -81};
+static const int8_t burst_dy[PARTICLES_PER_BURST] PROGMEM = 
+		{115, 81, 0, -81, -115, -81, 0, 81};
+
+// The pool. A particle is free when its life is 0.
+static int16_t particle_x[MAX_PARTICLES];
+static int16_t particle_y[MAX_PARTICLES];
+static int8_t particle_dx[MAX_PARTICLES];
+static int8_t particle_dy[MAX_PARTICLES];
+static uint8_t particle_life[MAX_PARTICLES];
+static PixelColour particle_colour[MAX_PARTICLES];
+static uint8_t num_alive;
+
+// Where the next frame's updates start, so that every particle gets its
+// turn when there are more than PARTICLE_UPDATE_BUDGET alive.
+static uint8_t next_particle;
+static uint32_t last_frame_time;
+
+void init_particles(void) {
+	for(uint8_t i = 0; i < MAX_PARTICLES; i++) {
+		particle_life[i] = 0;
+	}
+	num_alive = 0;
+	next_particle = 0;
+}
+
+// Is the particle's cell on the field?
+static uint8_t on_field(uint8_t i) {
+	return particle_x[i] >= 0 && particle_x[i] < TO_FIXED(FIELD_WIDTH) &&
+			particle_y[i] >= 0 && particle_y[i] < TO_FIXED(FIELD_HEIGHT);
+}
+
+// Draw (or erase) a particle. Particles are only drawn over empty cells
+// and only erased if they are still showing.
+static void draw_particle(uint8_t i, uint8_t erase) {
+	uint16_t address = LED_MATRIX_ADDRESS_FROM_XY(TO_CELL(particle_x[i]), 
+			TO_CELL(particle_y[i]));
+	PixelColour current = framebuffer_get_address(address);
+	uint8_t ours = framebuffer_get_address_layer(address) == LAYER_EFFECTS;
+
+	framebuffer_select_layer(LAYER_EFFECTS);
+	if(erase) {
+		if(ours && current == particle_colour[i]) {
+			framebuffer_set_address(address, COLOUR_BLACK);
+		}
+	} else if(current == COLOUR_BLACK) {
+		framebuffer_set_address(address, particle_colour[i]);
+	}
+	framebuffer_select_layer(LAYER_FIELD);
+}
+
+void particles_burst(uint8_t x, uint8_t y, PixelColour colour) {
+	uint8_t i = 0;
+	for(uint8_t n = 0; n < PARTICLES_PER_BURST; n++) {
+		// Find a free particle
+		while(i < MAX_PARTICLES && particle_life[i]) {
+			i++;
+		}
+		if(i == MAX_PARTICLES) {
+			// Pool is full - drop the rest of the burst
+			return;
+		}
+		// Start in the middle of the cell
+		particle_x[i] = TO_FIXED(x) + FIXED_HALF;
+		particle_y[i] = TO_FIXED(y) + FIXED_HALF;
+		particle_dx[i] = (int8_t)pgm_read_byte(&burst_dx[n]);
+		particle_dy[i] = (int8_t)pgm_read_byte(&burst_dy[n]);
+		particle_life[i] = PARTICLE_LIFETIME;
+		particle_colour[i] = colour;
+		num_alive++;
+	}
+}
+
+// Move one particle, removing it if it has expired or left the field.
+static void move_particle(uint8_t i) {
+	if(on_field(i)) {
+		draw_particle(i, 1);
+	}
+	particle_x[i] += particle_dx[i];
+	particle_y[i] += particle_dy[i];
+	particle_life[i]--;
+	if(particle_life[i] == 0 || !on_field(i)) {
+		particle_life[i] = 0;
+		num_alive--;
+	} else {
+		draw_particle(i, 0);
+	}
+}
+
+void particles_update(uint32_t current_time) {
+	uint8_t budget = PARTICLE_UPDATE_BUDGET;
+	uint8_t i;
+
+	if(num_alive == 0 || current_time < last_frame_time + PARTICLE_FRAME_MS) {
+		return;
+	}
+	last_frame_time = current_time;
+	for(uint8_t checked = 0; checked < MAX_PARTICLES && budget; checked++) {
+		i = next_particle;
+		next_particle = (next_particle + 1) % MAX_PARTICLES;
+		if(particle_life[i]) {
+			move_particle(i);
+			budget--;
+		}
+	}
+}
+
+uint8_t particles_alive(void) {
+	return num_alive;
+}
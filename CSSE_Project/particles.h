@@ -0,0 +1,41 @@
+/*
+ * particles.h
+ *
+ * Author: Matt Burton
+ *
+ * Short lived particles for explosions. Particles live in a fixed size
+ * pool and move with fixed point (8.8) positions and velocities. They are
+ * drawn into the framebuffer on the effects layer, only over empty cells,
+ * so they never hide or erase anything on the game field.
+ *
+ * Each frame at most PARTICLE_UPDATE_BUDGET particles are moved. If more
+ * than this are alive the remainder are moved on following frames (in
+ * turn), so a burst of hits slows the particles down rather than 
+ * stretching the frame.
+ */
+
+#ifndef PARTICLES_H_
+#define PARTICLES_H_
+
+#include <stdint.h>
+#include "pixel_colour.h"
+
+#define MAX_PARTICLES 16
+#define PARTICLE_UPDATE_BUDGET 8
+#define PARTICLE_FRAME_MS 40
+
+// Remove all particles (without drawing anything).
+void init_particles(void);
+
+// Throw out a ring of particles from game position (x,y). If the pool
+// is full, the remaining particles of the burst are dropped.
+void particles_burst(uint8_t x, uint8_t y, PixelColour colour);
+
+// Move the particles. Should be called from the main loop - does nothing
+// until PARTICLE_FRAME_MS has passed since the last frame.
+void particles_update(uint32_t current_time);
+
+// Returns the number of particles currently alive.
+uint8_t particles_alive(void);
+
+#endif /* PARTICLES_H_ */
@@ -10,8 +10,13 @@
 #include <avr/interrupt.h>
 #include <avr/pgmspace.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #include "ledmatrix.h"
+#include "framebuffer.h"
+#include "palette.h"
+#include "animation.h"
+#include "particles.h"
 #include "scrolling_char_display.h"
 #include "buttons.h"
 #include "serialio.h"
@@ -23,6 +28,17 @@
 #include "seven_seg.h"
 #include "game.h"
 #include "joystick.h"
+#include "hud.h"
+#include "autopilot.h"
+#include "lockstep.h"
+#include "telemetry.h"
+#include "framestream.h"
+#include "termview.h"
+#include "termui.h"
+#include "remote.h"
+#include "params.h"
+#include "shell.h"
+#include "log.h"
 
 #define F_CPU 8000000L
 #include <util/delay.h>
@@ -34,11 +50,31 @@ void splash_screen(void);
 void new_game(void);
 void play_game(void);
 void handle_game_over(void);
+static uint8_t apply_input(uint8_t input);
+static void update_asteroid_speed(void);
 
 
 // ASCII code for Escape character
 #define ESCAPE_CHAR 27
 
+// In two player mode the projectiles and asteroids are moved every so
+// many frames (see lockstep.h) rather than by the clock
+#define PROJECTILE_FRAMES	(200 / LOCKSTEP_FRAME_MS)
+#define ASTEROID_FRAMES		(ASTEROID_TICK_MS / LOCKSTEP_FRAME_MS)
+
+// The game over animation - dim the field, shift it off the display
+// and scroll the messages.
+static const char game_over_text[] PROGMEM = "GAME OVER NERD";
+static const char gg_text[] PROGMEM = "GG";
+static const AnimationStep game_over_timeline[] PROGMEM = {
+	{ANIM_FADE, BRIGHTNESS_MAX / 3, 50, 0, 0},
+	{ANIM_SHIFT_RIGHT, MATRIX_NUM_COLUMNS, 100, 0, 0},
+	{ANIM_RESET, 0, 0, 0, 0},
+	{ANIM_SCROLL_TEXT, 0, 100, game_over_text, COLOUR_GREEN},
+	{ANIM_SCROLL_TEXT, 0, 100, gg_text, COLOUR_GREEN},
+	{ANIM_END, 0, 0, 0, 0}
+};
+
 /////////////////////////////// main //////////////////////////////////
 int main(void) {
 	// Setup hardware and call backs. This will turn on 
@@ -52,19 +88,39 @@ int main(void) {
 	while(1) {
 		new_game();
 		play_game();
+		if(!is_game_over()) {
+			// A player interrupted a demonstration game, or the host asked
+			// for a new game (see remote.h) - start one
+			continue;
+		}
 		handle_game_over();
+		if(autopilot_mode() == AUTOPILOT_ATTRACT) {
+			// Back to the splash screen after a demonstration game
+			splash_screen();
+		}
 	}
 }
 
 void initialise_hardware(void) {
 	ledmatrix_setup();
 	init_button_interrupts();
-	// Setup serial port for 19200 baud communication with no echo
-	// of incoming characters
-	init_serial_stdio(19200,0);
+	// Load the parameters saved in EEPROM (see params.h)
+	init_params();
+	
+	// Setup serial port for communication (19200 baud unless another 
+	// rate has been saved) with no echo of incoming characters
+	init_serial_stdio(param_get(PARAM_BAUD),0);
+	
+	// Setup serial port 1 for telemetry, which is also the link to a 
+	// second board in two player mode. Its transmitter is left off until
+	// one of them needs it (see telemetry.h).
+	init_telemetry();
 	
 	init_timer0();
 	
+	// Full brightness on all layers
+	init_palette();
+	
 	// Initialise the seven_seg display, 
 	// with PORT A and PORT C pin 0 as outputs.
 	// Initialise PORT C to output the number of lives
@@ -84,40 +140,71 @@ void delay_ms(uint16_t count) {
 void splash_screen(void) {
 	uint32_t current_time = get_current_time();
 	uint32_t note_time = current_time;
+	uint32_t idle_start_time = current_time;
 	// Enjoy this trash song.
-	static uint16_t theme_song[30] = {123, 146, 164, 155, 146, 185, 174, 146, 164, 155, 
+	static const uint16_t theme_song[30] PROGMEM = {123, 146, 164, 155, 146, 185, 174, 146, 164, 155, 
 		138, 155, 116, 20000, 123, 146, 164, 155, 146, 185, 207, 196, 185, 174, 185, 174, 123, 164, 146}; 
-	static uint16_t	delays[30] = {165, 165, 83, 165, 333, 160, 500, 190, 120, 165, 
+	static const uint16_t delays[30] PROGMEM = {165, 165, 83, 165, 333, 160, 500, 190, 120, 165, 
 		333, 165, 500, 500, 165, 165, 83, 165, 333, 160, 333, 165, 333, 165, 83, 400, 333, 165, 800}; 
 	uint8_t i = 0;
-	// Clear terminal screen and output a message
+	int8_t button;
+	int16_t serial_input;
+	// Clear terminal screen (all of it scrolling, as it was before the 
+	// game's layout) and output a message
 	clear_terminal();
+	enable_scrolling_for_whole_display();
 	move_cursor(10,10);
 	printf_P(PSTR("Asteroids"));
 	move_cursor(10,12);
 	printf_P(PSTR("CSSE2010/7201 project by Matthew Burton"));
+	move_cursor(10,14);
+	printf_P(PSTR("Press H to host a two player game"));
 	
 	// Output the scrolling message to the LED matrix
-	// and wait for a push button to be pushed.
+	// and wait for a push button to be pushed. If none is pushed for
+	// AUTOPILOT_IDLE_MS, the autopilot plays a demonstration game. H on
+	// the terminal invites another board to a two player game, and if 
+	// another board invites us we join it.
 	ledmatrix_clear();
 	while(1) {
-		set_scrolling_display_text("ASTEROIDS MATTHEW BURTON S45293867", COLOUR_GREEN);
+		set_scrolling_display_text_P(PSTR("ASTEROIDS MATTHEW BURTON S45293867"), COLOUR_GREEN);
 		// Scroll the message until it has scrolled off the 
 		// display or a button is pushed
 		
 		while(scroll_display()) {
 			current_time = get_current_time();
 			// Every specified time interval, change the sound.
-			if (current_time >= note_time + delays[i]) {
+			if (current_time >= note_time + pgm_read_word(&delays[i])) {
 				init_sound();
-				set_sound(theme_song[i] + 300, 0.5);
+				set_sound(pgm_read_word(&theme_song[i]) + 300, 0.5);
 				i = (i + 1) % 30;
 				note_time = current_time;
 			}
 			_delay_ms(100);
 			// Play the sound for 100ms then end it.
 			kill_sound();
-			if(button_pushed() != NO_BUTTON_PUSHED) {
+			button = button_pushed();
+			serial_input = remote_poll();
+			if(serial_input == 'h' || serial_input == 'H') {
+				// Wait (up to LOCKSTEP_TIMEOUT_MS) for the other board
+				if(lockstep_host(current_time, param_get(PARAM_DIFFICULTY))) {
+					autopilot_set_mode(AUTOPILOT_OFF);
+					return;
+				}
+				move_cursor(10,14);
+				printf_P(PSTR("No reply from the other board"));
+				clear_to_end_of_line();
+			} else if(button != NO_BUTTON_PUSHED) {
+				autopilot_set_mode(AUTOPILOT_OFF);
+				return;
+			}
+			if(lockstep_poll_join()) {
+				autopilot_set_mode(AUTOPILOT_OFF);
+				return;
+			}
+			if(current_time >= idle_start_time + AUTOPILOT_IDLE_MS) {
+				kill_sound();
+				autopilot_set_mode(AUTOPILOT_ATTRACT);
 				return;
 			}
 		}
@@ -125,40 +212,55 @@ void splash_screen(void) {
 }
 
 void new_game(void) {
-	// Initialise the game and display
+	// Start with the display dark and fade the new field in
+	palette_set_brightness(0);
+	palette_fade_to(BRIGHTNESS_MAX, 40);
+	
+	LOG(LOG_LEVEL_INFO, LOG_GAME_START);
+	
+	// Initialise the game and display. In two player mode both boards
+	// must start with the same random numbers.
+	if(lockstep_active()) {
+		srandom(lockstep_seed());
+	}
 	initialise_game();
 	
-	// Clear the serial terminal
-	clear_terminal();
-	move_cursor(2,2);
-	printf_P(PSTR("Asteroids"));
+	// Clear the serial terminal and draw the layout
+	termui_init();
+	termview_invalidate();
+	if(lockstep_active()) {
+		termui_event(PSTR("Two player game started"), 0);
+	} else {
+		termui_event(PSTR("Game started"), 0);
+	}
 	
-	// Initialise the score
+	// Initialise the score and lives - they are shown by hud_update()
+	// and termui_update()
 	init_score();
-	move_cursor(2,4);
-	printf_P(PSTR("Score: %lu"), get_score());
-	
-	// Initialise lives.
 	init_lives();
+	hud_invalidate();
 		
 	init_joystick();
-
-	move_cursor(2, 6);
-	printf_P(PSTR("You have %lu lives remaining."), get_lives());
 	
-	// Clear a button push or serial input if any are waiting
+	// Clear a button push if one is waiting. Serial input is left alone -
+	// it may hold part of a remote control frame.
 	// (The cast to void means the return value is ignored.)
 	(void)button_pushed();
-	clear_serial_input_buffer();
 }
 
 void play_game(void) {
 	uint32_t current_time, last_move_time, last_move_asteroid, joystick_move_time;
 	int8_t button;
 	uint8_t joystick;
-	char serial_input, escape_sequence_char;
+	int16_t serial_input, escape_sequence_char;
 	uint8_t characters_into_escape_sequence = 0;
 	uint8_t sound_duration_1 = 0;
+	uint8_t input;
+	uint8_t new_frame;
+	int16_t remote_character;
+	int8_t pause_request;
+	uint8_t paused = 0;
+	uint32_t seed;
 	
 	// Get the current time and remember this as the last time the projectiles
     // were moved.
@@ -181,11 +283,23 @@ void play_game(void) {
 		escape_sequence_char = -1;
 		button = button_pushed();
 		joystick = joystick_moved();
+		if(autopilot_mode() == AUTOPILOT_ATTRACT && (button != NO_BUTTON_PUSHED ||
+				(int8_t)joystick != NO_JOYSTICK_MOVEMENT || serial_input_available())) {
+			// Any real input ends a demonstration game
+			autopilot_set_mode(AUTOPILOT_OFF);
+			return;
+		}
 		if(button == NO_BUTTON_PUSHED) {
-			// No push button was pushed, see if there is any serial input
-			if(serial_input_available()) {
-				// Serial data was available - read the data from standard input
-				serial_input = fgetc(stdin);
+			// No push button was pushed, see if there is any serial input. 
+			// Remote control frames from the host are dealt with first.
+			// Then anything for the command shell.
+			remote_character = remote_poll();
+			if(remote_character != -1 && shell_input(remote_character)) {
+				remote_character = -1;
+			}
+			if(remote_character != -1) {
+				// Serial data was available
+				serial_input = remote_character;
 				// Check if the character is part of an escape sequence
 				if(characters_into_escape_sequence == 0 && serial_input == ESCAPE_CHAR) {
 					// We've hit the first character in an escape sequence (escape)
@@ -210,23 +324,24 @@ void play_game(void) {
 			}
 		}
 		
-		// Process the input. 
+		// If there was no real input the autopilot (if it's on) may push
+		// a button instead
+		if(button == NO_BUTTON_PUSHED && serial_input == -1 && escape_sequence_char == -1) {
+			button = autopilot_input(current_time);
+		}
+		
+		// Process the input. Moves and shots become an INPUT_... value (see
+		// lockstep.h) which is applied below.
+		input = INPUT_NONE;
+		pause_request = remote_pause();
 		if(button==3 || escape_sequence_char=='D' || serial_input=='L' || serial_input=='l' || joystick==1) {
 			// Button 3 pressed OR left cursor key escape sequence completed OR
 			// letter L (lowercase or uppercase) pressed - attempt to move left
-			if(move_base(MOVE_LEFT)) {
-				init_sound();
-				set_sound(600, 2);
-				sound_duration_1 = 255;
-			}
+			input = INPUT_LEFT;
 		} else if(button==2 || escape_sequence_char=='A' || serial_input==' ' || joystick==3) {
 			// Button 2 pressed or up cursor key escape sequence completed OR
 			// space bar pressed - attempt to fire projectile
-			if (fire_projectile()) {
-				init_sound();
-				set_sound(494, 2);
-				sound_duration_1 = 255;
-			}
+			input = INPUT_FIRE;
 		} else if(button==1 || escape_sequence_char=='B') {
 			// Button 1 pressed OR down cursor key escape sequence completed
 			// Ignore at present
@@ -234,29 +349,57 @@ void play_game(void) {
 		|| joystick==2) {
 			// Button 0 pressed OR right cursor key escape sequence completed OR
 			// letter R (lowercase or uppercase) pressed - attempt to move right
-			if(move_base(MOVE_RIGHT)) {
-				init_sound();
-				set_sound(600, 2);
-				sound_duration_1 = 255;
-			}
+			input = INPUT_RIGHT;
 		} else if(serial_input == 'p' || serial_input == 'P') {
-			// Unimplemented feature - pause/unpause the game until 'p' or 'P' is
-			// pressed again
+			// Pause/unpause the game
+			pause_request = !paused;
+		} else if(serial_input == 'a' || serial_input == 'A') {
+			// Turn the autopilot on or off (for soak testing)
+			autopilot_set_mode(autopilot_mode() == AUTOPILOT_OFF ? 
+					AUTOPILOT_ON : AUTOPILOT_OFF);
+			termui_event(autopilot_mode() == AUTOPILOT_OFF ? 
+					PSTR("Autopilot off") : PSTR("Autopilot on"), 0);
+		} else if(serial_input == 'v' || serial_input == 'V') {
+			// Start or stop streaming the display to a viewer on the host
+			framestream_enable(!framestream_enabled());
+			termui_event(framestream_enabled() ? 
+					PSTR("Display stream on") : PSTR("Display stream off"), 0);
+		} else if(serial_input == 't' || serial_input == 'T') {
+			// Show or hide the copy of the display on the terminal
+			termview_enable(!termview_enabled());
+		}
+		
+		if(input == INPUT_NONE) {
+			input = remote_input();
+		}
+		if(pause_request != REMOTE_NO_PAUSE && pause_request != paused && 
+				!lockstep_active()) {
+			// Pause or carry on. The clock stops while we're paused, so
+			// nothing moves. (Not in two player mode - the other board 
+			// would give up waiting for us.)
+			paused = pause_request;
 			toggle_timer();
 			kill_sound();
-			while(1) {
-				// Get the button push and discard it
-				button_pushed();
-				if(serial_input_available()) {
-					// Serial data was available - read the data from standard input
-					serial_input = fgetc(stdin);
-					if (serial_input == 'p' || serial_input == 'P') {
-						break;
-					}
-				}
+			termui_event(paused ? PSTR("Paused") : PSTR("Carrying on"), 0);
+		}
+		if(paused) {
+			input = INPUT_NONE;
+		}
+		if(remote_seed(&seed) && !lockstep_active()) {
+			// The host wants a new game with the given random seed
+			if(paused) {
+				toggle_timer();
 			}
-			toggle_timer();
-		} 
+			srandom(seed);
+			return;
+		}
+		
+		if(lockstep_active()) {
+			// Both boards apply the input together a few frames from now
+			lockstep_set_input(input);
+		} else if(apply_input(input)) {
+			sound_duration_1 = 255;
+		}
 		
 		// Check if it is time to kill the sound
 		if (sound_duration_1 == 0) {
@@ -266,69 +409,145 @@ void play_game(void) {
 		}
 		
 		current_time = get_current_time();
-		if(!is_game_over() && current_time >= last_move_time + 200) {
-			// 500ms (0.5 second) has passed since the last time we moved
-			// the projectiles - move them - and keep track of the time we 
-			// moved them
-			advance_projectiles();
-			last_move_time = current_time;
+		if(lockstep_active()) {
+			// Run each frame once both players' inputs for it are here. 
+			// Everything that changes the game happens in frames, so both
+			// boards stay the same.
+			while(!is_game_over() && lockstep_next_frame(current_time)) {
+				for(uint8_t player = 0; player < LOCKSTEP_PLAYERS; player++) {
+					if(apply_input(lockstep_input(player))) {
+						sound_duration_1 = 255;
+					}
+				}
+				if(lockstep_frame() % PROJECTILE_FRAMES == 0) {
+					advance_projectiles();
+				}
+				if(lockstep_frame() % ASTEROID_FRAMES == 0) {
+					update_asteroid_speed();
+					advance_asteroids();
+				}
+				lockstep_end_frame(get_game_checksum());
+			}
+			if(lockstep_status() != LOCKSTEP_OK) {
+				// The other board has gone, or no longer agrees with us - 
+				// the game can't go on
+				if(lockstep_status() == LOCKSTEP_DESYNC) {
+					termui_event(PSTR("Out of step with the other board at frame %u"),
+							lockstep_frame());
+				} else {
+					termui_event(PSTR("Lost contact with the other board"), 0);
+				}
+				subtract_lives(get_lives());
+			}
+		} else {
+			if(!is_game_over() && 
+					current_time >= last_move_time + param_get(PARAM_PROJECTILE_MS)) {
+				// 200ms (0.2 seconds, or as set by the proj_ms parameter) has
+				// passed since the last time we moved the projectiles - move
+				// them - and keep track of the time we moved them
+				advance_projectiles();
+				last_move_time = current_time;
+			}
+			
+			if(current_time >= last_move_asteroid + ASTEROID_TICK_MS) {
+				// A tick has passed since the last time we moved the asteroids
+				// - move them - and keep track of the time we moved them.
+				update_asteroid_speed();
+				advance_asteroids();
+				
+				last_move_asteroid = current_time;
+			}
 		}
 		
-		if(current_time >= joystick_move_time + 50) {
-			// 500ms (0.5 second) has passed since the last time we moved
-			// the projectiles - move them - and keep track of the time we
-			// moved them
+		if(current_time >= joystick_move_time + param_get(PARAM_JOYSTICK_MS)) {
+			// 50ms (or as set by the joy_ms parameter) has passed since 
+			// the last time we read the joystick - read it again
 			step_joystick();
 			joystick_move_time = current_time;
 		}
-	
-		if(current_time >= last_move_asteroid + 1500 - get_score() * 10) {
-			// 1000ms (1 seconds) has passed since the last time we moved
-			// the asteroids - move them - and keep track of the time we
-			// moved them
-			advance_asteroids();
-			
-			last_move_asteroid = current_time;
-		}
 		
+		// Send any pixels changed this time through the loop to the
+		// LED matrix, and the score and lives if they have changed.
+		particles_update(current_time);
+		palette_step(current_time);
+		new_frame = (framebuffer_flush() != 0);
+		framestream_update(current_time);
+		termview_update(current_time);
+		hud_update();
+		termui_update(current_time, new_frame);
+		shell_update();
 		
 		/* Displays the score on the seven segment display. 
 		Wraps around at 100. The refresh rate is every 3 milliseconds. 
-		Might need to use above method to improve performance.
 		*/
-		set_value(get_score());
 		display_data(current_time);
 	}
 	// We get here if the game is over.
+	lockstep_stop();
+}
+
+// Apply a player's input (INPUT_... - see lockstep.h) to the game, and
+// start the matching sound. Returns 1 if the sound was started (the 
+// move or shot succeeded), 0 otherwise.
+static uint8_t apply_input(uint8_t input) {
+	if((input == INPUT_LEFT && move_base(MOVE_LEFT)) || 
+			(input == INPUT_RIGHT && move_base(MOVE_RIGHT))) {
+		init_sound();
+		set_sound(600, 2);
+		return 1;
+	} else if(input == INPUT_FIRE && fire_projectile()) {
+		init_sound();
+		set_sound(494, 2);
+		return 1;
+	}
+	return 0;
+}
+
+// The asteroids start at the speed set by the difficulty parameter (a
+// percentage of their normal speed) and speed up with the score, by 
+// about 1/150 of their normal speed per point. In two player mode both
+// boards use the host's difficulty, so that they stay the same.
+static void update_asteroid_speed(void) {
+	uint16_t difficulty = lockstep_active() ? 
+			lockstep_difficulty() : param_get(PARAM_DIFFICULTY);
+	uint32_t scale = (uint32_t)ASTEROID_SPEED_SCALE_NORMAL * 
+			difficulty / 100 + get_score() * 17UL / 10;
+	
+	if(scale < ASTEROID_SPEED_SCALE_MAX) {
+		set_asteroid_speed_scale(scale);
+	} else {
+		set_asteroid_speed_scale(ASTEROID_SPEED_SCALE_MAX);
+	}
 }
 
 void handle_game_over() {
+	LOG2(LOG_LEVEL_INFO, LOG_GAME_OVER, get_score(), get_tick_number());
+	if(autopilot_mode() != AUTOPILOT_OFF) {
+		LOG1(LOG_LEVEL_INFO, LOG_AUTOPILOT_PRESSES, autopilot_presses());
+		termui_event(PSTR("Autopilot pushed %u buttons"), autopilot_presses());
+	}
 	kill_sound();
-	uint32_t current_time = get_current_time();
-	uint8_t game_over_count = 0;
-	game_over_count += game_over_animation(current_time, 1);
-	move_cursor(10,14);
-	printf_P(PSTR("GAME OVER"));
-	move_cursor(10,15);
-	printf_P(PSTR("Press a button to start again"));
-	while(button_pushed() == NO_BUTTON_PUSHED) {
+	uint32_t current_time;
+	animation_start(game_over_timeline);
+	termui_event(PSTR("GAME OVER - score %u"), get_score());
+	termui_event(PSTR("Press a button to start again"), 0);
+	while(1) {
+		if(button_pushed() != NO_BUTTON_PUSHED) {
+			// A player wants a game - that ends any demonstration
+			if(autopilot_mode() == AUTOPILOT_ATTRACT) {
+				autopilot_set_mode(AUTOPILOT_OFF);
+			}
+			break;
+		}
 		current_time = get_current_time();
 		display_data(current_time);
-		if (game_over_count < 16) {
-			game_over_count += game_over_animation(current_time, 1);
-		} else if (game_over_count == 16) {
-			game_over_count += game_over_animation(current_time, 2);
-		}  else if (game_over_count < 100) {
-			game_over_count += game_over_animation(current_time, 3);
-		} else if (game_over_count == 100) {
-			game_over_count += game_over_animation(current_time, 4);
-		} else if (game_over_count < 110) {
-			game_over_count += game_over_animation(current_time, 5);
+		termui_update(current_time, 0);
+		// Play the animation until it finishes or a button is pushed. The 
+		// autopilot doesn't wait for a button once the animation is done.
+		if(!animation_step(current_time) && autopilot_mode() != AUTOPILOT_OFF) {
+			break;
 		}
 	}
+	animation_stop();
 	init_lives();
 }
-
-
-
-
@@ -0,0 +1,187 @@
+/*
+ * remote.c
+ *
+ * Written by Matt Burton
+ */
+
+#include "remote.h"
+#include "serialio.h"
+#include "lockstep.h"
+#include "game.h"
+#include "score.h"
+#include "lives.h"
+#include "log.h"
+
+#define MAX_PAYLOAD		4
+#define MAX_REPLY		7
+
+// Where we are in the frame being received
+#define WAIT_SOF		0
+#define WAIT_SEQUENCE	1
+#define WAIT_COMMAND	2
+#define WAIT_LENGTH		3
+#define WAIT_PAYLOAD	4
+#define WAIT_CHECK		5
+
+static uint8_t state = WAIT_SOF;
+static uint8_t sequence;
+static uint8_t command;
+static uint8_t length;
+static uint8_t received;
+static uint8_t check;
+static uint8_t payload[MAX_PAYLOAD];
+
+static uint8_t input = INPUT_NONE;
+static int8_t pause_request = REMOTE_NO_PAUSE;
+static uint8_t seed_requested;
+static uint32_t seed;
+
+static void handle_command(void);
+static void reply(uint8_t status, const uint8_t* data, uint8_t data_length);
+
+int16_t remote_poll(void) {
+	int16_t c;
+	
+	while((c = serial_read_raw(SERIAL_PORT0)) != -1) {
+		switch(state) {
+			case WAIT_SOF:
+				if(c != REMOTE_SOF) {
+					return c;
+				}
+				state = WAIT_SEQUENCE;
+				break;
+			case WAIT_SEQUENCE:
+				sequence = check = c;
+				state = WAIT_COMMAND;
+				break;
+			case WAIT_COMMAND:
+				command = c;
+				check ^= c;
+				state = WAIT_LENGTH;
+				break;
+			case WAIT_LENGTH:
+				length = c;
+				check ^= c;
+				received = 0;
+				if(length > MAX_PAYLOAD) {
+					// Not a frame we could have been sent - start again
+					state = WAIT_SOF;
+				} else {
+					state = length ? WAIT_PAYLOAD : WAIT_CHECK;
+				}
+				break;
+			case WAIT_PAYLOAD:
+				payload[received++] = c;
+				check ^= c;
+				if(received == length) {
+					state = WAIT_CHECK;
+				}
+				break;
+			case WAIT_CHECK:
+				state = WAIT_SOF;
+				if(c != check) {
+					LOG1(LOG_LEVEL_INFO, LOG_REMOTE_BAD_CHECK, sequence);
+					reply(REMOTE_BAD_CHECK, 0, 0);
+				} else {
+					handle_command();
+				}
+				// One command per call, so each is acted on in turn
+				return -1;
+		}
+	}
+	return -1;
+}
+
+uint8_t remote_input(void) {
+	uint8_t result = input;
+	
+	input = INPUT_NONE;
+	return result;
+}
+
+int8_t remote_pause(void) {
+	int8_t result = pause_request;
+	
+	pause_request = REMOTE_NO_PAUSE;
+	return result;
+}
+
+uint8_t remote_seed(uint32_t* new_seed) {
+	if(!seed_requested) {
+		return 0;
+	}
+	seed_requested = 0;
+	*new_seed = seed;
+	return 1;
+}
+
+static void handle_command(void) {
+	uint8_t state_data[MAX_REPLY - 1];
+	uint16_t value;
+	
+	switch(command) {
+		case 'M':
+			if(length == 1 && payload[0] == MOVE_LEFT) {
+				input = INPUT_LEFT;
+			} else if(length == 1 && payload[0] == MOVE_RIGHT) {
+				input = INPUT_RIGHT;
+			} else {
+				break;
+			}
+			reply(REMOTE_OK, 0, 0);
+			return;
+		case 'F':
+			input = INPUT_FIRE;
+			reply(REMOTE_OK, 0, 0);
+			return;
+		case 'P':
+			if(length == 1) {
+				pause_request = payload[0] ? 1 : 0;
+				reply(REMOTE_OK, 0, 0);
+				return;
+			}
+			break;
+		case 'S':
+			if(length == 4) {
+				seed = payload[0] | ((uint32_t)payload[1] << 8) | 
+						((uint32_t)payload[2] << 16) | ((uint32_t)payload[3] << 24);
+				seed_requested = 1;
+				reply(REMOTE_OK, 0, 0);
+				return;
+			}
+			break;
+		case 'Q':
+			value = get_tick_number();
+			state_data[0] = (uint8_t)value;
+			state_data[1] = (uint8_t)(value >> 8);
+			state_data[2] = get_base_position();
+			value = get_score();
+			state_data[3] = (uint8_t)value;
+			state_data[4] = (uint8_t)(value >> 8);
+			state_data[5] = get_lives();
+			reply(REMOTE_OK, state_data, sizeof(state_data));
+			return;
+	}
+	reply(REMOTE_BAD_COMMAND, 0, 0);
+}
+
+// Send a reply to the current command. If there isn't room in the 
+// serial output buffer the reply is dropped (the host times out).
+static void reply(uint8_t status, const uint8_t* data, uint8_t data_length) {
+	uint8_t frame[6 + MAX_REPLY];
+	uint8_t i;
+	
+	frame[0] = REMOTE_SOF;
+	frame[1] = sequence;
+	frame[2] = command | 0x80;
+	frame[3] = data_length + 1;
+	frame[4] = status;
+	for(i = 0; i < data_length; i++) {
+		frame[5 + i] = data[i];
+	}
+	frame[5 + i] = 0;
+	for(i = 1; i < 5 + data_length; i++) {
+		frame[5 + data_length] ^= frame[i];
+	}
+	(void)serial_write_raw(SERIAL_PORT0, frame, 6 + data_length);
+}
@@ -0,0 +1,59 @@
+/*
+ * remote.h
+ *
+ * Author: Matt Burton
+ *
+ * Remote control of the game from the host (test rigs, bots) with 
+ * binary command frames on the serial port, mixed in with ordinary 
+ * terminal input. A frame is:
+ *	REMOTE_SOF, sequence number, command, payload length, payload, check
+ * where check is the exclusive or of the sequence number, command, 
+ * length and payload bytes. Every command is answered with a frame in 
+ * the same format, with the same sequence number and the command with
+ * its top bit set. The reply payload starts with a REMOTE_... status,
+ * so the host can match replies to commands and time the round trip.
+ *
+ * Commands (multi-byte values least significant byte first):
+ *	'M' move - 1 byte, MOVE_LEFT or MOVE_RIGHT (see game.h). Any other
+ *	    value is answered with REMOTE_BAD_COMMAND.
+ *	'F' fire
+ *	'P' pause - 1 byte, 1 to pause or 0 to carry on
+ *	'S' set seed - 4 bytes. Starts a new game with the given random seed.
+ *	'Q' query state - the reply is the status, the tick number (2 bytes,
+ *	    see get_tick_number()), base position, score (2 bytes) and lives.
+ *
+ * remote_poll() reads the serial input until it has handled a whole 
+ * frame or finds a character which isn't part of one (which it returns
+ * for play_game() to deal with as before). Frames are read in full 
+ * each time through the main loop rather than a character at a time.
+ */
+
+#ifndef REMOTE_H_
+#define REMOTE_H_
+
+#include <stdint.h>
+
+#define REMOTE_SOF	0x02
+
+// Reply status
+#define REMOTE_OK			0
+#define REMOTE_BAD_CHECK	1
+#define REMOTE_BAD_COMMAND	2
+
+// Returned by remote_pause() when there is no pause command
+#define REMOTE_NO_PAUSE		(-1)
+
+// Handle any remote control frame waiting. Returns the next character
+// of serial input which isn't part of a frame, or -1 if there is none
+// (yet).
+int16_t remote_poll(void);
+
+// The results of the last command. Each is cleared once read.
+// remote_input() - INPUT_... (see lockstep.h), for move and fire.
+// remote_pause() - 1 or 0, or REMOTE_NO_PAUSE.
+// remote_seed() - returns 1 and sets *seed if a new game was asked for.
+uint8_t remote_input(void);
+int8_t remote_pause(void);
+uint8_t remote_seed(uint32_t* seed);
+
+#endif /* REMOTE_H_ */
@@ -6,16 +6,25 @@
 
 #include "score.h"
 
-uint32_t score;
+uint16_t score;
+uint8_t score_version;
 
 void init_score(void) {
 	score = 0;
+	score_version++;
 }
 
 void add_to_score(uint16_t value) {
-	score += value;
+	if(value) {
+		score += value;
+		score_version++;
+	}
 }
 
-uint32_t get_score(void) {
+uint16_t get_score(void) {
 	return score;
 }
+
+uint8_t get_score_version(void) {
+	return score_version;
+}
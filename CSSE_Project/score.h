@@ -11,6 +11,11 @@
 
 void init_score(void);
 void add_to_score(uint16_t value);
-uint32_t get_score(void);
+uint16_t get_score(void);
 
-#endif /* SCORE_H_ */
\ No newline at end of file
+// Changes every time the score changes (including init_score()), so a
+// display can tell whether it needs to be redrawn by comparing this
+// with the value when it was last drawn.
+uint8_t get_score_version(void);
+
+#endif /* SCORE_H_ */
@@ -117,9 +117,12 @@ static volatile const uint8_t* next_col_ptr = 0;
  * next_char_to_display will be used to point to the next
  * character from this string to be displayed.
  */
-static char* display_string;
+static const char* display_string;
 
-static volatile char* next_char_to_display = 0;
+/* Whether display_string is in program memory */
+static uint8_t string_in_progmem;
+
+static volatile const char* next_char_to_display = 0;
 
 /*
  * Set the message to be displayed - we just copy the 
@@ -132,10 +135,17 @@ static volatile char* next_char_to_display = 0;
 void set_scrolling_display_text(char* string_to_display, PixelColour c) {
 	colour = c;
 	display_string = string_to_display;
+	string_in_progmem = 0;
 	next_col_ptr = 0;
 	next_char_to_display = 0;
 }
 
+void set_scrolling_display_text_P(const char* string_to_display, PixelColour c) {
+	set_scrolling_display_text(0, c);
+	display_string = string_to_display;
+	string_in_progmem = 1;
+}
+
 /*
  * Scroll the display. Should be called whenever the display
  * is to be scrolled. 
@@ -184,7 +194,11 @@ uint8_t scroll_display(void) {
 		 * (next_char_to_display) so that it points to the character 
 		 * after.
 		 */
-		next_char = *(next_char_to_display++);
+		if(string_in_progmem) {
+			next_char = pgm_read_byte(next_char_to_display++);
+		} else {
+			next_char = *(next_char_to_display++);
+		}
 		if(next_char == 0) {
 			/* We reached the null character at the end of the string.
 			 * There is no next character, reset our pointer to 
@@ -198,13 +212,13 @@ uint8_t scroll_display(void) {
 			 * be displayed will be the first column of the letter
 			 * data for that letter
 			 */
-			next_col_ptr = (const uint8_t*)pgm_read_word(&letters[next_char - 'a']);
+			next_col_ptr = (const uint8_t*)pgm_read_ptr(&letters[next_char - 'a']);
 		} else if (next_char >= 'A' && next_char <= 'Z') {
 			/* Upper case character */
-			next_col_ptr = (const uint8_t*)pgm_read_word(&letters[next_char - 'A']);
+			next_col_ptr = (const uint8_t*)pgm_read_ptr(&letters[next_char - 'A']);
 		} else if (next_char >= '0' && next_char <= '9') {
 			/* Digit */
-			next_col_ptr = (const uint8_t*)pgm_read_word(&numbers[next_char - '0']);
+			next_col_ptr = (const uint8_t*)pgm_read_ptr(&numbers[next_char - '0']);
 		}
 	} else {
 		/* We're not outputting a column of dots and there is 
@@ -22,6 +22,10 @@
  */
 void set_scrolling_display_text(char* string, PixelColour colour);
 
+/* As above, for a string in program memory. 
+ */
+void set_scrolling_display_text_P(const char* string, PixelColour colour);
+
 /* Scroll the display. Should be called whenever the display
  * is to be scrolled one pixel to the left. It is recommended that
  * this function NOT be called from an interrupt service routine as
@@ -2,22 +2,30 @@
  * FILE: serialio.c
  *
  * Written by Peter Sutton.
- * 
- * Module to allow standard input/output routines to be used via 
- * serial port 0. The init_serial_stdio() method must be called before
+ *
+ * Module to allow standard input/output routines to be used via
+ * the serial ports. The init_serial_stdio() method must be called before
  * any standard IO methods (e.g. printf). We use interrupt-based output
- * and a circular buffer to store output messages. (This allows us 
- * to print many characters at once to the buffer and have them 
+ * and a circular buffer to store output messages. (This allows us
+ * to print many characters at once to the buffer and have them
  * output by the UART as speed permits.) If the buffer fills up, the
  * put method will either
  * (1) if interrupts are enabled, block until there is room in it, or
  * (2) if interrupts are disabled, will discard the character.
  * Input is blocking - requesting input from stdin will block
- * until a character is available. If interrupts are disabled when 
+ * until a character is available. If interrupts are disabled when
  * input is sought, then this will block forever.
  * The function input_available() can be used to test whether there is
  * input available to read from stdin.
+ * If flow control is on for a port, the sender is asked to stop (by
+ * XOFF, or by raising RTS) when the input buffer fills up past its high
+ * water mark and to start again (XON, or RTS low) once it has been read
+ * down to its low water mark.
  *
+ * Each port (USART0 and USART1) has its own buffers, interrupt handlers
+ * and stream. The code is shared - each port's state is kept in a
+ * SerialPort structure, and the interrupt handlers just pass the port
+ * on.
  */
 
 #include <stdio.h>
@@ -26,76 +34,161 @@
 #include <avr/io.h>
 #include <avr/interrupt.h>
 
+#include "serialio.h"
+
 /* System clock rate in Hz. (L at the end indicates this is a long constant) */
 #define SYSCLK 8000000L
 
-/* Global variables */
-/* Circular buffer to hold outgoing characters. The insert_pos variable
- * keeps track of the position (0 to OUTPUT_BUFFER_SIZE-1) that the next
- * outgoing character should be written to. bytes_in_buffer keeps
- * count of the number of characters currently stored in the buffer 
- * (ranging from 0 to OUTPUT_BUFFER_SIZE). This number of bytes immediately
- * prior to the current insert_pos are the bytes waiting to be output.
- * If the insert_pos reaches the end of the buffer it will wrap around
- * to the beginning (assuming those bytes have been output).
- * NOTE - OUTPUT_BUFFER_SIZE can not be larger than 255 without changing
- * the type of the variables below (currently defined as 8 bit unsigned ints).
+/* Above this baud rate the UART is run in double speed mode, which
+ * gives a closer match to the rate asked for.
  */
-#define OUTPUT_BUFFER_SIZE 255
-volatile char out_buffer[OUTPUT_BUFFER_SIZE];
-volatile uint8_t out_insert_pos;
-volatile uint8_t bytes_in_out_buffer;
+#define DOUBLE_SPEED_BAUD 38400
 
-/* Circular buffer to hold incoming characters. Works on same principle
- * as output buffer
- */
-#define INPUT_BUFFER_SIZE 16
-volatile char input_buffer[INPUT_BUFFER_SIZE];
-volatile uint8_t input_insert_pos;
-volatile uint8_t bytes_in_input_buffer;
-volatile uint8_t input_overrun;
+#define XON		0x11
+#define XOFF	0x13
 
-/* Variable to keep track of whether incoming characters are to be echoed
+/* The state of one port.
+ *
+ * out_buffer is a circular buffer to hold outgoing characters. The
+ * out_insert_pos variable keeps track of the position (0 to
+ * out_size-1) that the next outgoing character should be written to.
+ * bytes_in_out_buffer keeps count of the number of characters currently
+ * stored in the buffer (ranging from 0 to out_size). This number of
+ * bytes immediately prior to the current insert_pos are the bytes
+ * waiting to be output. If the insert_pos reaches the end of the buffer
+ * it will wrap around to the beginning (assuming those bytes have been
+ * output).
+ * NOTE - buffer sizes can not be larger than 255 without changing
+ * the type of the variables below (currently defined as 8 bit unsigned ints).
+ *
+ * input_buffer is a circular buffer to hold incoming characters. Works
+ * on same principle as output buffer.
+ *
+ * do_echo keeps track of whether incoming characters are to be echoed
  * back or not.
+ *
+ * flow is the port's flow control mode, and stopped is set while we've
+ * asked the sender to stop. flow_char is an XON or XOFF waiting to be
+ * sent (ahead of anything in out_buffer), or 0 if there isn't one.
+ * rts_port, rts_ddr and rts_mask give the RTS pin, if the port has one.
+ *
+ * stats counts the port's receive errors (see serialio.h).
+ *
+ * ucsrb and udr are the port's UART registers. (The bit positions in
+ * UCSRnA and UCSRnB are the same for both UARTs, so the USART0 names are
+ * used.)
  */
-static int8_t do_echo;
+typedef struct {
+	volatile char* out_buffer;
+	uint8_t out_size;
+	volatile uint8_t out_insert_pos;
+	volatile uint8_t bytes_in_out_buffer;
+	volatile char* input_buffer;
+	uint8_t input_size;
+	volatile uint8_t input_insert_pos;
+	volatile uint8_t bytes_in_input_buffer;
+	uint8_t input_high_water;
+	uint8_t input_low_water;
+	int8_t do_echo;
+	uint8_t flow;
+	volatile uint8_t stopped;
+	volatile uint8_t flow_char;
+	volatile uint8_t* rts_port;
+	volatile uint8_t* rts_ddr;
+	uint8_t rts_mask;
+	volatile SerialStats stats;
+	volatile uint8_t* ucsrb;
+	volatile uint8_t* udr;
+} SerialPort;
 
-/* Function prototypes 
+static volatile char out_buffer0[SERIAL0_OUTPUT_BUFFER_SIZE];
+static volatile char input_buffer0[SERIAL0_INPUT_BUFFER_SIZE];
+static volatile char out_buffer1[SERIAL1_OUTPUT_BUFFER_SIZE];
+static volatile char input_buffer1[SERIAL1_INPUT_BUFFER_SIZE];
+
+#ifdef SERIAL0_RTS_BIT
+#define SERIAL0_RTS	&SERIAL0_RTS_PORT, &SERIAL0_RTS_DDR, (1 << SERIAL0_RTS_BIT)
+#else
+#define SERIAL0_RTS	0, 0, 0
+#endif
+#ifdef SERIAL1_RTS_BIT
+#define SERIAL1_RTS	&SERIAL1_RTS_PORT, &SERIAL1_RTS_DDR, (1 << SERIAL1_RTS_BIT)
+#else
+#define SERIAL1_RTS	0, 0, 0
+#endif
+
+static SerialPort ports[SERIAL_NUM_PORTS] = {
+	{out_buffer0, SERIAL0_OUTPUT_BUFFER_SIZE, 0, 0,
+			input_buffer0, SERIAL0_INPUT_BUFFER_SIZE, 0, 0,
+			SERIAL0_INPUT_HIGH_WATER, SERIAL0_INPUT_LOW_WATER, 0,
+			SERIAL0_FLOW_CONTROL, 0, 0, SERIAL0_RTS, {0, 0, 0, 0, 0},
+			&UCSR0B, &UDR0},
+	{out_buffer1, SERIAL1_OUTPUT_BUFFER_SIZE, 0, 0,
+			input_buffer1, SERIAL1_INPUT_BUFFER_SIZE, 0, 0,
+			SERIAL1_INPUT_HIGH_WATER, SERIAL1_INPUT_LOW_WATER, 0,
+			SERIAL1_FLOW_CONTROL, 0, 0, SERIAL1_RTS, {0, 0, 0, 0, 0},
+			&UCSR1B, &UDR1}
+};
+
+/* Function prototypes
  */
-void init_serial_stdio(long baudrate, int8_t echo);
-static int uart_put_char(char, FILE*);
-static int uart_get_char(FILE*);
+static int put_char(SerialPort* port, char c);
+static char take_input_char(SerialPort* port);
+static void transmit_next(SerialPort* port);
+static void receive(SerialPort* port, uint8_t status, char c);
+static void flow_stop(SerialPort* port);
+static void flow_resume(SerialPort* port);
+static int uart0_put_char(char, FILE*);
+static int uart0_get_char(FILE*);
+static int uart1_put_char(char, FILE*);
+static int uart1_get_char(FILE*);
 
-/* Setup a stream that uses the uart get and put functions. We will
- * make standard input and output use this stream below.
+/* Setup a stream for each port that uses the uart get and put functions.
+ * We will make standard input and output use port 0's stream below.
  */
-static FILE myStream = FDEV_SETUP_STREAM(uart_put_char, uart_get_char,
-		_FDEV_SETUP_RW);
+static FILE streams[SERIAL_NUM_PORTS] = {
+	FDEV_SETUP_STREAM(uart0_put_char, uart0_get_char, _FDEV_SETUP_RW),
+	FDEV_SETUP_STREAM(uart1_put_char, uart1_get_char, _FDEV_SETUP_RW)
+};
 
-void init_serial_stdio(long baudrate, int8_t echo) {
+void init_serial_port(uint8_t port_number, long baudrate, int8_t echo) {
+	SerialPort* port = &ports[port_number];
 	uint16_t ubrr;
+	uint8_t double_speed = (baudrate > DOUBLE_SPEED_BAUD);
+
 	/*
 	 * Initialise our buffers
 	*/
-	out_insert_pos = 0;
-	bytes_in_out_buffer = 0;
-	input_insert_pos = 0;
-	bytes_in_input_buffer = 0;
-	input_overrun = 0;
-	
+	port->out_insert_pos = 0;
+	port->bytes_in_out_buffer = 0;
+	port->input_insert_pos = 0;
+	port->bytes_in_input_buffer = 0;
+	port->stopped = 0;
+	port->flow_char = 0;
+
 	/*
 	 * Record whether we're going to echo characters or not
 	*/
-	do_echo = echo;
-	
+	port->do_echo = echo;
+
 	/* Configure the serial port baud rate */
-	/* (This differs from the datasheet formula so that we get 
+	/* (This differs from the datasheet formula so that we get
 	 * rounding to the nearest integer while using integer division
 	 * (which truncates)).
 	*/
-	ubrr = ((SYSCLK / (8 * baudrate)) + 1)/2 - 1;
-	UBRR0 = ubrr;
-	
+	if(double_speed) {
+		ubrr = ((SYSCLK / (4 * baudrate)) + 1)/2 - 1;
+	} else {
+		ubrr = ((SYSCLK / (8 * baudrate)) + 1)/2 - 1;
+	}
+	if(port_number == SERIAL_PORT0) {
+		UBRR0 = ubrr;
+		UCSR0A = double_speed ? (1 << U2X0) : 0;
+	} else {
+		UBRR1 = ubrr;
+		UCSR1A = double_speed ? (1 << U2X1) : 0;
+	}
+
 	/*
 	 * Enable transmission and receiving via UART. We don't enable
 	 * the UDR empty interrupt here (we wait until we've got a
@@ -103,90 +196,245 @@ void init_serial_stdio(long baudrate, int8_t echo) {
 	 * NOTE: Interrupts must be enabled globally for this
 	 * library to work, but we do not do this here.
 	*/
-	UCSR0B = (1<<RXEN0)|(1<<TXEN0);
-	
+	*port->ucsrb = (1<<RXEN0)|(1<<TXEN0);
+
+	/*
+	 * Enable receive complete interrupt
+	*/
+	*port->ucsrb |= (1 <<RXCIE0);
+
 	/*
-	 * Enable receive complete interrupt 
+	 * If the port has an RTS pin, make it an output and set it low
+	 * (ready to receive)
 	*/
-	UCSR0B  |= (1 <<RXCIE0);
+	if(port->rts_port) {
+		*port->rts_port &= ~port->rts_mask;
+		*port->rts_ddr |= port->rts_mask;
+	} else if(port->flow == SERIAL_FLOW_RTS) {
+		port->flow = SERIAL_FLOW_NONE;
+	}
+}
+
+void serial_port_enable_output(uint8_t port_number, uint8_t enable) {
+	SerialPort* port = &ports[port_number];
+	uint8_t interrupts_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	if(enable) {
+		*port->ucsrb |= (1 << TXEN0);
+	} else {
+		/* Drop whatever is waiting, so put_char() never waits for a
+		 * transmitter that isn't running */
+		*port->ucsrb &= ~((1 << TXEN0) | (1 << UDRIE0));
+		port->bytes_in_out_buffer = 0;
+		port->flow_char = 0;
+	}
+	if(interrupts_enabled) {
+		sei();
+	}
+}
 
-	/* Set up our stream so the put and get functions below are used 
+void init_serial_stdio(long baudrate, int8_t echo) {
+	init_serial_port(SERIAL_PORT0, baudrate, echo);
+
+	/* Set up our stream so the put and get functions below are used
 	 * to write/read characters via the serial port when we use
 	 * stdio functions
 	*/
-	stdout = &myStream;
-	stdin = &myStream;
+	stdout = &streams[SERIAL_PORT0];
+	stdin = &streams[SERIAL_PORT0];
+}
+
+FILE* serial_port_stream(uint8_t port_number) {
+	return &streams[port_number];
+}
+
+int8_t serial_port_input_available(uint8_t port_number) {
+	return (ports[port_number].bytes_in_input_buffer != 0);
+}
+
+void clear_serial_port_input_buffer(uint8_t port_number) {
+	/* Just adjust our buffer data so it looks empty (counting what
+	 * we throw away) */
+	SerialPort* port = &ports[port_number];
+	uint8_t interrupts_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	port->stats.discarded += port->bytes_in_input_buffer;
+	port->input_insert_pos = 0;
+	port->bytes_in_input_buffer = 0;
+	flow_resume(port);
+	if(interrupts_enabled) {
+		sei();
+	}
+}
+
+void serial_port_set_flow(uint8_t port_number, uint8_t flow) {
+	SerialPort* port = &ports[port_number];
+	uint8_t interrupts_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	/* Let the sender go before changing mode, so it isn't left
+	 * stopped */
+	flow_resume(port);
+	if(flow == SERIAL_FLOW_RTS && !port->rts_port) {
+		flow = SERIAL_FLOW_NONE;
+	}
+	port->flow = flow;
+	if(interrupts_enabled) {
+		sei();
+	}
+}
+
+uint8_t serial_port_flow(uint8_t port_number) {
+	return ports[port_number].flow;
+}
+
+void serial_port_get_stats(uint8_t port_number, SerialStats* stats) {
+	uint8_t interrupts_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	*stats = ports[port_number].stats;
+	if(interrupts_enabled) {
+		sei();
+	}
+}
+
+void serial_port_clear_stats(uint8_t port_number) {
+	volatile SerialStats* stats = &ports[port_number].stats;
+	uint8_t interrupts_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	stats->overruns = 0;
+	stats->framing_errors = 0;
+	stats->data_overruns = 0;
+	stats->discarded = 0;
+	stats->flow_stops = 0;
+	if(interrupts_enabled) {
+		sei();
+	}
 }
 
 int8_t serial_input_available(void) {
-	return (bytes_in_input_buffer != 0);
+	return serial_port_input_available(SERIAL_PORT0);
 }
 
 void clear_serial_input_buffer(void) {
-	/* Just adjust our buffer data so it looks empty */
-	input_insert_pos = 0;
-	bytes_in_input_buffer = 0;
+	clear_serial_port_input_buffer(SERIAL_PORT0);
+}
+
+int8_t serial_write_raw(uint8_t port_number, const uint8_t* data, uint8_t length) {
+	SerialPort* port = &ports[port_number];
+	uint8_t interrupts_enabled = bit_is_set(SREG, SREG_I);
+
+	cli();
+	if(!(*port->ucsrb & (1 << TXEN0)) || 
+			port->out_size - port->bytes_in_out_buffer < length) {
+		if(interrupts_enabled) {
+			sei();
+		}
+		return 0;
+	}
+	while(length--) {
+		port->out_buffer[port->out_insert_pos++] = *data++;
+		port->bytes_in_out_buffer++;
+		if(port->out_insert_pos == port->out_size) {
+			port->out_insert_pos = 0;
+		}
+	}
+	*port->ucsrb |= (1 << UDRIE0);
+	if(interrupts_enabled) {
+		sei();
+	}
+	return 1;
+}
+
+uint8_t serial_output_space(uint8_t port_number) {
+	if(!(*ports[port_number].ucsrb & (1 << TXEN0))) {
+		return 0;
+	}
+	return ports[port_number].out_size - ports[port_number].bytes_in_out_buffer;
+}
+
+int16_t serial_read_raw(uint8_t port_number) {
+	if(ports[port_number].bytes_in_input_buffer == 0) {
+		return -1;
+	}
+	return (uint8_t)take_input_char(&ports[port_number]);
 }
 
-static int uart_put_char(char c, FILE* stream) {
+static int put_char(SerialPort* port, char c) {
 	uint8_t interrupts_enabled;
-	
-	/* Add the character to the buffer for transmission (if there 
+
+	/* Add the character to the buffer for transmission (if there
 	 * is space to do so). If not we wait until the buffer has space.
 	 * If the character is \n, we output \r (carriage return)
 	 * also.
 	*/
 	if(c == '\n') {
-		uart_put_char('\r', stream);
+		put_char(port, '\r');
+	}
+
+	/* Nothing can be sent while the port's output is off */
+	if(!(*port->ucsrb & (1 << TXEN0))) {
+		return 1;
 	}
-	
+
 	/* If the buffer is full and interrupts are disabled then we
 	 * abort - we don't output the character since the buffer will
 	 * never be emptied if interrupts are disabled. If the buffer is full
-	 * and interrupts are enabled then we loop until the buffer has 
+	 * and interrupts are enabled then we loop until the buffer has
 	 * enough space. The bytes_in_buffer variable will get modified by the
 	 * ISR which extracts bytes from the buffer.
 	*/
 	interrupts_enabled = bit_is_set(SREG, SREG_I);
-	while(bytes_in_out_buffer >= OUTPUT_BUFFER_SIZE) {
+	while(port->bytes_in_out_buffer >= port->out_size) {
 		if(!interrupts_enabled) {
 			return 1;
-		}		
+		}
 		/* else do nothing */
 	}
-	
+
 	/* Add the character to the buffer for transmission if there
 	 * is space to do so. We advance the insert_pos to the next
 	 * character position. If this is beyond the end of the buffer
-	 * we wrap around back to the beginning of the buffer 
+	 * we wrap around back to the beginning of the buffer
 	 * NOTE: we disable interrupts before modifying the buffer. This
 	 * prevents the ISR from modifying the buffer at the same time.
 	 * We reenable them if they were enabled when we entered the
 	 * function.
-	*/	
+	*/
 	cli();
-	out_buffer[out_insert_pos++] = c;
-	bytes_in_out_buffer++;
-	if(out_insert_pos == OUTPUT_BUFFER_SIZE) {
+	port->out_buffer[port->out_insert_pos++] = c;
+	port->bytes_in_out_buffer++;
+	if(port->out_insert_pos == port->out_size) {
 		/* Wrap around buffer pointer if necessary */
-		out_insert_pos = 0;
+		port->out_insert_pos = 0;
 	}
 	/* Reenable interrupts (UDR Empty interrupt may have been
 	 * disabled) - we ensure it is now enabled so that it will
 	 * fire and deal with the next character in the buffer. */
-	UCSR0B |= (1 << UDRIE0);
+	*port->ucsrb |= (1 << UDRIE0);
 	if(interrupts_enabled) {
 		sei();
 	}
 	return 0;
 }
 
-int uart_get_char(FILE* stream) {
+static int get_char(SerialPort* port) {
+	char c;
+
 	/* Wait until we've received a character */
-	while(bytes_in_input_buffer == 0) {
+	while(port->bytes_in_input_buffer == 0) {
 		/* do nothing */
 	}
-	
+	c = take_input_char(port);
+
+	/* If the character is a carriage return, turn it into a
+	 * linefeed
+	 */
+	if (c == '\r') {
+		c = '\n';
+	}
+	return c;
+}
+
+static char take_input_char(SerialPort* port) {
 	/*
 	 * Turn interrupts off and remove a character from the input
 	 * buffer. We reenable interrupts if they were on.
@@ -197,107 +445,192 @@ int uart_get_char(FILE* stream) {
 	uint8_t interrupts_enabled = bit_is_set(SREG, SREG_I);
 	cli();
 	char c;
-	if(input_insert_pos - bytes_in_input_buffer < 0) {
+	if(port->input_insert_pos < port->bytes_in_input_buffer) {
 		/* Need to wrap around */
-		c = input_buffer[input_insert_pos - bytes_in_input_buffer
-				+ INPUT_BUFFER_SIZE];
+		c = port->input_buffer[port->input_insert_pos - port->bytes_in_input_buffer
+				+ port->input_size];
 	} else {
-		c = input_buffer[input_insert_pos - bytes_in_input_buffer];
+		c = port->input_buffer[port->input_insert_pos - port->bytes_in_input_buffer];
+	}
+
+	/* Decrement our count of bytes in the input buffer, and let the
+	 * sender start again if it was stopped and there is now room */
+	port->bytes_in_input_buffer--;
+	if(port->bytes_in_input_buffer <= port->input_low_water) {
+		flow_resume(port);
 	}
-	
-	/* Decrement our count of bytes in the input buffer */
-	bytes_in_input_buffer--;
 	if(interrupts_enabled) {
 		sei();
-	}	
+	}
 	return c;
 }
 
+static int uart0_put_char(char c, FILE* stream) {
+	return put_char(&ports[SERIAL_PORT0], c);
+}
+
+static int uart0_get_char(FILE* stream) {
+	return get_char(&ports[SERIAL_PORT0]);
+}
+
+static int uart1_put_char(char c, FILE* stream) {
+	return put_char(&ports[SERIAL_PORT1], c);
+}
+
+static int uart1_get_char(FILE* stream) {
+	return get_char(&ports[SERIAL_PORT1]);
+}
+
 /*
- * Define the interrupt handler for UART Data Register Empty (i.e. 
- * another character can be taken from our buffer and written out)
+ * Output the next character from a port's buffer (called when the
+ * UART Data Register is empty).
  */
-ISR(USART0_UDRE_vect) 
-{
-	/* Check if we have data in our buffer */
-	if(bytes_in_out_buffer > 0) {
+static void transmit_next(SerialPort* port) {
+	/* An XON or XOFF goes out first - it can't wait behind the
+	 * buffer */
+	if(port->flow_char) {
+		*port->udr = port->flow_char;
+		port->flow_char = 0;
+	} else if(port->bytes_in_out_buffer > 0) {
+		/* Check if we have data in our buffer */
 		/* Yes we do - remove the pending byte and output it
 		 * via the UART. The pending byte (character) is the
-		 * one which is "bytes_in_buffer" characters before the 
-		 * insert_pos (taking into account that we may 
+		 * one which is "bytes_in_buffer" characters before the
+		 * insert_pos (taking into account that we may
 		 * need to wrap around to the end of the buffer).
 		 */
 		char c;
-		if(out_insert_pos - bytes_in_out_buffer < 0) {
+		if(port->out_insert_pos < port->bytes_in_out_buffer) {
 			/* Need to wrap around */
-			c = out_buffer[out_insert_pos - bytes_in_out_buffer
-				+ OUTPUT_BUFFER_SIZE];
+			c = port->out_buffer[port->out_insert_pos - port->bytes_in_out_buffer
+				+ port->out_size];
 		} else {
-			c = out_buffer[out_insert_pos - bytes_in_out_buffer];
+			c = port->out_buffer[port->out_insert_pos - port->bytes_in_out_buffer];
 		}
-		/* Decrement our count of the number of bytes in the 
-		 * buffer 
+		/* Decrement our count of the number of bytes in the
+		 * buffer
 		 */
-		bytes_in_out_buffer--;
-		
+		port->bytes_in_out_buffer--;
+
 		/* Output the character via the UART */
-		UDR0 = c;
+		*port->udr = c;
 	} else {
 		/* No data in the buffer. We disable the UART Data
-		 * Register Empty interrupt because otherwise it 
-		 * will trigger again immediately this ISR exits. 
+		 * Register Empty interrupt because otherwise it
+		 * will trigger again immediately this ISR exits.
 		 * The interrupt is reenabled when a character is
 		 * placed in the buffer.
 		 */
-		UCSR0B &= ~(1<<UDRIE0);
+		*port->ucsrb &= ~(1<<UDRIE0);
 	}
 }
 
 /*
- * Define the interrupt handler for UART Receive Complete (i.e. 
- * we can read a character. The character is read and placed in
- * the input buffer.
+ * Place a received character in a port's input buffer. status is the
+ * value of UCSRnA when it arrived.
  */
+static void receive(SerialPort* port, uint8_t status, char c) {
+	/* A character with a framing error is garbage - count it and
+	 * drop it. A data overrun means characters before this one were
+	 * lost in the UART, but this one is good.
+	 */
+	if(status & (1 << FE0)) {
+		port->stats.framing_errors++;
+		return;
+	}
+	if(status & (1 << DOR0)) {
+		port->stats.data_overruns++;
+	}
 
-ISR(USART0_RX_vect) 
-{
-	/* Read the character - we ignore the possibility of overrun. */
-	char c;
-	c = UDR0;
-		
-	if(do_echo && bytes_in_out_buffer < OUTPUT_BUFFER_SIZE) {
+	if(port->do_echo && port->bytes_in_out_buffer < port->out_size) {
 		/* If echoing is enabled and there is output buffer
 		 * space, echo the received character back to the UART.
 		 * (If there is no output buffer space, characters
 		 * will be lost.)
 		 */
-		uart_put_char(c, 0);
-	}
-	
-	/* 
-	 * Check if we have space in our buffer. If not, set the overrun
-	 * flag and throw away the character. (We never clear the 
-	 * overrun flag - it's up to the programmer to check/clear
-	 * this flag if desired.)
+		put_char(port, c);
+	}
+
+	/*
+	 * Check if we have space in our buffer. If not, count the overrun
+	 * and throw away the character.
 	 */
-	if(bytes_in_input_buffer >= INPUT_BUFFER_SIZE) {
-		input_overrun = 1;
+	if(port->bytes_in_input_buffer >= port->input_size) {
+		port->stats.overruns++;
 	} else {
-		/* If the character is a carriage return, turn it into a
-		 * linefeed 
-		*/
-		if (c == '\r') {
-			c = '\n';
-		}
-		
-		/* 
-		 * There is room in the input buffer 
+		/*
+		 * There is room in the input buffer
 		 */
-		input_buffer[input_insert_pos++] = c;
-		bytes_in_input_buffer++;
-		if(input_insert_pos == INPUT_BUFFER_SIZE) {
+		port->input_buffer[port->input_insert_pos++] = c;
+		port->bytes_in_input_buffer++;
+		if(port->input_insert_pos == port->input_size) {
 			/* Wrap around buffer pointer if necessary */
-			input_insert_pos = 0;
+			port->input_insert_pos = 0;
+		}
+		if(port->bytes_in_input_buffer >= port->input_high_water) {
+			flow_stop(port);
 		}
 	}
 }
+
+/*
+ * Ask the sender to stop / start again. (Interrupts must be off.)
+ */
+static void flow_stop(SerialPort* port) {
+	if(port->stopped || port->flow == SERIAL_FLOW_NONE) {
+		return;
+	}
+	port->stopped = 1;
+	port->stats.flow_stops++;
+	if(port->flow == SERIAL_FLOW_XON_XOFF) {
+		port->flow_char = XOFF;
+		*port->ucsrb |= (1 << UDRIE0);
+	} else {
+		*port->rts_port |= port->rts_mask;
+	}
+}
+
+static void flow_resume(SerialPort* port) {
+	if(!port->stopped) {
+		return;
+	}
+	port->stopped = 0;
+	if(port->flow == SERIAL_FLOW_XON_XOFF) {
+		port->flow_char = XON;
+		*port->ucsrb |= (1 << UDRIE0);
+	} else if(port->flow == SERIAL_FLOW_RTS) {
+		*port->rts_port &= ~port->rts_mask;
+	}
+}
+
+/*
+ * Define the interrupt handlers for UART Data Register Empty (i.e.
+ * another character can be taken from our buffer and written out)
+ */
+ISR(USART0_UDRE_vect)
+{
+	transmit_next(&ports[SERIAL_PORT0]);
+}
+
+ISR(USART1_UDRE_vect)
+{
+	transmit_next(&ports[SERIAL_PORT1]);
+}
+
+/*
+ * Define the interrupt handlers for UART Receive Complete (i.e.
+ * we can read a character. The character is read and placed in
+ * the input buffer.
+ */
+ISR(USART0_RX_vect)
+{
+	/* Read the status first - reading the character clears it */
+	uint8_t status = UCSR0A;
+	receive(&ports[SERIAL_PORT0], status, UDR0);
+}
+
+ISR(USART1_RX_vect)
+{
+	uint8_t status = UCSR1A;
+	receive(&ports[SERIAL_PORT1], status, UDR1);
+}
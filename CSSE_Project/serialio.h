@@ -4,8 +4,10 @@
  * Author: Peter Sutton
  * 
  * Module to allow standard input/output routines to be used via 
- * serial port 0. The init_serial_stdio() method must be called before
- * any standard IO methods (e.g. printf). We use interrupt-based serial
+ * the serial ports. The init_serial_stdio() method must be called before
+ * any standard IO methods (e.g. printf) - it sets up port 0 as stdin and
+ * stdout. Port 1 is set up with init_serial_port() and written to
+ * through its own stream (serial_port_stream()) or the raw functions. We use interrupt-based serial
  * IO and a circular buffer to store output messages. (This allows us 
  * to print many characters at once to the buffer and have them 
  * output by the UART as speed permits.) Interrupts must be enabled 
@@ -16,9 +18,126 @@
 #ifndef SERIALIO_H_
 #define SERIALIO_H_
 
+#include <stdio.h>
 #include <stdint.h>
 
-/* Initialise serial IO using the UART. baudrate specifies the desired
+#define SERIAL_PORT0		0
+#define SERIAL_PORT1		1
+#define SERIAL_NUM_PORTS	2
+
+/* Flow control modes. With SERIAL_FLOW_XON_XOFF, XOFF (0x13) and XON
+ * (0x11) are sent to the other end, so the port's output shouldn't 
+ * contain those bytes for any other reason. (XON and XOFF received are
+ * treated as ordinary input.) SERIAL_FLOW_RTS drives an output pin
+ * high to stop the sender - it is only available on a port with an
+ * RTS pin, given by defining (e.g.) SERIAL0_RTS_PORT, SERIAL0_RTS_DDR
+ * and SERIAL0_RTS_BIT as PORTB, DDRB and 2.
+ */
+#define SERIAL_FLOW_NONE		0
+#define SERIAL_FLOW_XON_XOFF	1
+#define SERIAL_FLOW_RTS			2
+
+/* Buffer sizes for each port (no larger than 255), the input buffer 
+ * levels at which the sender is asked to stop and to start again, and
+ * the flow control mode each port starts with. The buffers take a 
+ * good part of the 2K of RAM, so they are no bigger than the longest
+ * thing written or received at once (see termview.h, termui.h,
+ * framestream.h and lockstep.c) needs. The high water mark leaves room 
+ * for what the sender has already sent when it is told to stop. Port 0
+ * carries binary remote control replies (which may contain
+ * 0x11 and 0x13), so it doesn't use XON/XOFF - it has no flow control
+ * unless an RTS pin is given for it.
+ */
+#ifndef SERIAL0_OUTPUT_BUFFER_SIZE
+#define SERIAL0_OUTPUT_BUFFER_SIZE	128
+#endif
+#ifndef SERIAL0_INPUT_BUFFER_SIZE
+#define SERIAL0_INPUT_BUFFER_SIZE	32
+#endif
+#ifndef SERIAL0_INPUT_HIGH_WATER
+#define SERIAL0_INPUT_HIGH_WATER	(SERIAL0_INPUT_BUFFER_SIZE - 16)
+#endif
+#ifndef SERIAL0_INPUT_LOW_WATER
+#define SERIAL0_INPUT_LOW_WATER		(SERIAL0_INPUT_BUFFER_SIZE / 4)
+#endif
+#ifndef SERIAL0_FLOW_CONTROL
+#ifdef SERIAL0_RTS_PORT
+#define SERIAL0_FLOW_CONTROL		SERIAL_FLOW_RTS
+#else
+#define SERIAL0_FLOW_CONTROL		SERIAL_FLOW_NONE
+#endif
+#endif
+#ifndef SERIAL1_OUTPUT_BUFFER_SIZE
+#define SERIAL1_OUTPUT_BUFFER_SIZE	64
+#endif
+#ifndef SERIAL1_INPUT_BUFFER_SIZE
+#define SERIAL1_INPUT_BUFFER_SIZE	32
+#endif
+#ifndef SERIAL1_INPUT_HIGH_WATER
+#define SERIAL1_INPUT_HIGH_WATER	(SERIAL1_INPUT_BUFFER_SIZE - 8)
+#endif
+#ifndef SERIAL1_INPUT_LOW_WATER
+#define SERIAL1_INPUT_LOW_WATER		(SERIAL1_INPUT_BUFFER_SIZE / 4)
+#endif
+#ifndef SERIAL1_FLOW_CONTROL
+#define SERIAL1_FLOW_CONTROL		SERIAL_FLOW_NONE
+#endif
+
+/* Counts of input lost on a port:
+ *	overruns - characters thrown away because the input buffer was full
+ *	framing_errors - characters received with a framing error (FE), 
+ *		which are thrown away
+ *	data_overruns - times characters were lost in the UART itself 
+ *		because the receive interrupt was held up (DOR)
+ *	discarded - characters thrown away by clear_serial_input_buffer()
+ *		or clear_serial_port_input_buffer()
+ *	flow_stops - times the sender was asked to stop
+ * The counts wrap around at 65535.
+ */
+typedef struct {
+	uint16_t overruns;
+	uint16_t framing_errors;
+	uint16_t data_overruns;
+	uint16_t discarded;
+	uint16_t flow_stops;
+} SerialStats;
+
+/* Initialise one serial port. baudrate and echo are as for 
+ * init_serial_stdio(). Rates above 38400 use the UART's double speed 
+ * mode.
+ */
+void init_serial_port(uint8_t port, long baudrate, int8_t echo);
+
+/* Turn a port's transmitter on or off. While it is off the port's TXD
+ * pin is an ordinary I/O pin (port 1's, PD3, is also used by the seven
+ * segment display - see seven_seg.c), anything waiting to be sent is 
+ * thrown away and nothing more can be queued. Input is unaffected. The
+ * transmitter is on after init_serial_port().
+ */
+void serial_port_enable_output(uint8_t port, uint8_t enable);
+
+/* Return the stdio stream for a port (e.g. for fprintf()).
+ */
+FILE* serial_port_stream(uint8_t port);
+
+/* As serial_input_available() and clear_serial_input_buffer(), but for
+ * any port.
+ */
+int8_t serial_port_input_available(uint8_t port);
+void clear_serial_port_input_buffer(uint8_t port);
+
+/* Change a port's flow control mode (one of the SERIAL_FLOW_ values).
+ * SERIAL_FLOW_RTS on a port with no RTS pin turns flow control off.
+ */
+void serial_port_set_flow(uint8_t port, uint8_t flow);
+uint8_t serial_port_flow(uint8_t port);
+
+/* Copy a port's error counts into stats, or set them all back to zero.
+ */
+void serial_port_get_stats(uint8_t port, SerialStats* stats);
+void serial_port_clear_stats(uint8_t port);
+
+/* Initialise serial IO using UART 0. baudrate specifies the desired
  * baud rate (e.g. 19200) and echo determines whether incoming characters
  * are echoed back to the UART output as they are received (zero means no
  * echo, non-zero means echo)
@@ -32,8 +151,28 @@ void init_serial_stdio(long baudrate, int8_t echo);
 int8_t serial_input_available(void);
 
 /* Discard any input waiting to be read from the serial port. (Characters may
- * have been typed when we didn't want them - clear them.
+ * have been typed when we didn't want them - clear them. They are counted
+ * - see SerialStats.
  */
 void clear_serial_input_buffer(void);
 
+/* Queue binary data for output on a port exactly as given (no \n to \r\n
+ * translation). Never waits - if there isn't room in the output buffer 
+ * for all of it (or the port's output is off), nothing is queued and 0
+ * is returned. Returns 1 on 
+ * success.
+ */
+int8_t serial_write_raw(uint8_t port, const uint8_t* data, uint8_t length);
+
+/* Return the number of bytes of free space in a port's output buffer
+ * (0 if the port's output is off).
+ */
+uint8_t serial_output_space(uint8_t port);
+
+/* Return a port's next character of input exactly as it was received (0 to
+ * 255), or -1 if there is none. Never waits. (Characters read with 
+ * standard IO functions have carriage returns turned into linefeeds.)
+ */
+int16_t serial_read_raw(uint8_t port);
+
 #endif /* SERIALIO_H_ */
\ No newline at end of file
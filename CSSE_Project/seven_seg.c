@@ -16,7 +16,9 @@ volatile uint8_t seven_seg_cc;
 void init_display(void) {
 	// Set Port C to output the digits.
 	DDRC = 0xFF;
-	// Port C pin 0 to oscillate between digits.
+	// Port D pin 3 to oscillate between digits. (This is also serial 
+	// port 1's transmit pin, which takes it over while the port is 
+	// sending - see telemetry.h.)
 	DDRD |= (1 << 3);
 	// The side to display on, 0 -> right, 1 -> left
 	seven_seg_cc = 0;
@@ -0,0 +1,194 @@
+/*
+ * shell.c
+ *
+ * Written by Matt Burton
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <avr/pgmspace.h>
+
+#include "shell.h"
+#include "params.h"
+#include "terminalio.h"
+#include "log.h"
+#include "serialio.h"
+
+#define ESCAPE_CHAR		27
+#define MAX_WORDS		3
+#define NOT_LISTING		0xFF
+
+// The command being typed (if active)
+static uint8_t active;
+static char line[SHELL_LINE_LENGTH + 1];
+static uint8_t length;
+
+// The next parameter to list, and whether a save is in progress
+static uint8_t list_position = NOT_LISTING;
+static uint8_t saving;
+
+static void run_command(void);
+static uint8_t split_words(char* text, char** words);
+static uint8_t parse_value(uint8_t param, const char* text, uint16_t* value);
+static void print_serial_stats(void);
+
+uint8_t shell_input(char c) {
+	if(!active) {
+		if(c != SHELL_START_CHAR) {
+			return 0;
+		}
+		active = 1;
+		length = 0;
+		move_cursor(1, SHELL_ROW);
+		clear_to_end_of_line();
+		putchar(SHELL_START_CHAR);
+		return 1;
+	}
+	
+	if(c == ESCAPE_CHAR) {
+		active = 0;
+		move_cursor(1, SHELL_ROW);
+		clear_to_end_of_line();
+	} else if(c == '\r' || c == '\n') {
+		active = 0;
+		line[length] = 0;
+		run_command();
+	} else if((c == '\b' || c == 127) && length > 0) {
+		length--;
+		move_cursor(2 + length, SHELL_ROW);
+		putchar(' ');
+	} else if(c >= ' ' && c < 127 && length < SHELL_LINE_LENGTH) {
+		line[length] = c;
+		length++;
+		move_cursor(1 + length, SHELL_ROW);
+		putchar(c);
+	}
+	return 1;
+}
+
+void shell_update(void) {
+	if(list_position != NOT_LISTING) {
+		// One parameter per call
+		move_cursor(1, SHELL_ROW + 1 + list_position);
+		param_print(list_position);
+		if(++list_position == NUM_PARAMS) {
+			list_position = NOT_LISTING;
+		}
+	}
+	params_save_step();
+	if(saving && !params_saving()) {
+		saving = 0;
+		LOG(LOG_LEVEL_INFO, LOG_PARAMS_SAVED);
+		move_cursor(1, SHELL_ROW + 1);
+		printf_P(PSTR("saved"));
+	}
+}
+
+static void run_command(void) {
+	char* words[MAX_WORDS];
+	uint8_t num_words = split_words(line, words);
+	int8_t param = -1;
+	uint16_t value;
+	
+	// Clear the old output
+	for(uint8_t row = SHELL_ROW + 1; row <= SHELL_ROW + NUM_PARAMS; row++) {
+		move_cursor(1, row);
+		clear_to_end_of_line();
+	}
+	list_position = NOT_LISTING;
+	move_cursor(1, SHELL_ROW + 1);
+	
+	if(num_words >= 2) {
+		param = param_find(words[1]);
+	}
+	if(num_words == 0) {
+		return;
+	} else if(strcmp_P(words[0], PSTR("list")) == 0 && num_words == 1) {
+		list_position = 0;
+	} else if(strcmp_P(words[0], PSTR("save")) == 0 && num_words == 1) {
+		params_save();
+		saving = 1;
+		printf_P(PSTR("saving"));
+	} else if(strcmp_P(words[0], PSTR("defaults")) == 0 && num_words == 1) {
+		params_set_defaults();
+		printf_P(PSTR("defaults set"));
+	} else if(strcmp_P(words[0], PSTR("serial")) == 0 && num_words == 1) {
+		print_serial_stats();
+	} else if((strcmp_P(words[0], PSTR("get")) == 0 && num_words == 2) ||
+			(strcmp_P(words[0], PSTR("set")) == 0 && num_words == 3)) {
+		if(param == -1) {
+			printf_P(PSTR("no parameter %s"), words[1]);
+		} else if(num_words == 3 && (!parse_value(param, words[2], &value) ||
+				!param_set(param, value))) {
+			printf_P(PSTR("bad value: "));
+			param_print(param);
+		} else {
+			if(num_words == 3) {
+				LOG2(LOG_LEVEL_DEBUG, LOG_PARAM_SET, param, value);
+			}
+			param_print(param);
+		}
+	} else {
+		printf_P(PSTR("get NAME, set NAME VALUE, list, save, defaults, serial"));
+	}
+}
+
+// Split text into up to MAX_WORDS words (separated by spaces), in place.
+// Returns the number of words, or MAX_WORDS + 1 if there are too many.
+static uint8_t split_words(char* text, char** words) {
+	uint8_t count = 0;
+	
+	while(1) {
+		while(*text == ' ') {
+			*text++ = 0;
+		}
+		if(*text == 0) {
+			return count;
+		}
+		if(count == MAX_WORDS) {
+			return MAX_WORDS + 1;
+		}
+		words[count++] = text;
+		while(*text != ' ' && *text != 0) {
+			text++;
+		}
+	}
+}
+
+// Read a value for the given parameter. Returns 1 if it's valid (for
+// the parameter's type - the range isn't checked), 0 otherwise.
+static uint8_t parse_value(uint8_t param, const char* text, uint16_t* value) {
+	uint32_t number = 0;
+	
+	if(param_type(param) == PARAM_TYPE_ON_OFF) {
+		if(strcmp_P(text, PSTR("on")) == 0 || strcmp_P(text, PSTR("1")) == 0) {
+			*value = 1;
+		} else if(strcmp_P(text, PSTR("off")) == 0 || strcmp_P(text, PSTR("0")) == 0) {
+			*value = 0;
+		} else {
+			return 0;
+		}
+		return 1;
+	}
+	do {
+		if(*text < '0' || *text > '9') {
+			return 0;
+		}
+		number = number * 10 + (*text - '0');
+		if(number > 0xFFFF) {
+			return 0;
+		}
+	} while(*++text);
+	*value = number;
+	return 1;
+}
+
+// Show the terminal port's input error counts
+static void print_serial_stats(void) {
+	SerialStats stats;
+	
+	serial_port_get_stats(SERIAL_PORT0, &stats);
+	printf_P(PSTR("overrun %u framing %u dor %u discarded %u stops %u"),
+			stats.overruns, stats.framing_errors, stats.data_overruns,
+			stats.discarded, stats.flow_stops);
+}
@@ -0,0 +1,39 @@
+/*
+ * shell.h
+ *
+ * Author: Matt Burton
+ *
+ * A command line on the serial terminal for changing parameters (see 
+ * params.h) while the game runs. Typing SHELL_START_CHAR starts a 
+ * command, which is typed on row SHELL_ROW of the terminal and run when
+ * enter is pressed (escape abandons it). While a command is being typed
+ * the keys don't control the game. Commands are
+ *	get NAME		show a parameter
+ *	set NAME VALUE	change a parameter (numbers, or on/off)
+ *	list			show all the parameters
+ *	save			save the parameters to EEPROM
+ *	defaults		set all the parameters back to their defaults
+ *	serial			show the terminal's serial input error counts
+ *
+ * Characters are passed in one at a time by the main loop, and 
+ * shell_update() does a little more of any long job (listing, saving)
+ * each time it is called, so the shell never holds the game up.
+ */
+
+#ifndef SHELL_H_
+#define SHELL_H_
+
+#include <stdint.h>
+
+#define SHELL_START_CHAR	':'
+#define SHELL_ROW			18
+#define SHELL_LINE_LENGTH	24
+
+// Pass a character of serial input to the shell. Returns 1 if the 
+// shell used it, 0 if it is for the game.
+uint8_t shell_input(char c);
+
+// Call every time through the main loop.
+void shell_update(void);
+
+#endif /* SHELL_H_ */
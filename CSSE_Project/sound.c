@@ -10,8 +10,7 @@
 
 #include <avr/io.h>
 #define F_CPU 8000000UL	// 8MHz
-#include <stdlib.h>
-/* Stdlib needed for random() - random number generator */
+#include "params.h"
 
 uint16_t	notes[7] = {261, 294, 329, 349, 392, 440, 494};
 // For a given frequency (Hz), return the clock period (in terms of the
@@ -34,8 +33,9 @@ void kill_sound() {
 }
 
 void init_sound() {
-	// Make pin OC1B be an output
-	if ((PIND & (1 << 6)) >> 6) {
+	// Make pin OC1B be an output - if the sound switch (pin D6) is on and 
+	// sound hasn't been turned off with the sound parameter
+	if (((PIND & (1 << 6)) >> 6) && param_get(PARAM_SOUND)) {
 		DDRD |= (1 << 4);
 	
 		// Set up timer/counter 1 for Fast PWM, counting from 0 to the value in OCR1A
@@ -63,9 +63,14 @@ void set_sound(uint16_t freq, float dutycycle) {
 	}
 }
 
-// Play a random sound
+// Play a random sound. The notes come from their own generator (a 16 bit
+// Galois LFSR) rather than random(): how many are played depends on how
+// fast the display is, and in a two player game (see lockstep.h) both
+// boards' random() must stay in step.
+static uint16_t note_lfsr = 0xACE1;
 void random_sound() {
-	set_sound(notes[random() % 7], 2);
+	note_lfsr = (note_lfsr >> 1) ^ ((note_lfsr & 1) ? 0xB400 : 0);
+	set_sound(notes[note_lfsr % 7], 2);
 }
 
 
@@ -0,0 +1,40 @@
+/*
+ * spatial.c
+ *
+ * Written by Matt Burton
+ */
+
+#include "spatial.h"
+
+uint8_t spatial_next[MAX_ENTITIES];
+static uint8_t bucket_head[SPATIAL_NUM_BUCKETS];
+
+void spatial_clear(void) {
+	for(uint8_t bucket = 0; bucket < SPATIAL_NUM_BUCKETS; bucket++) {
+		bucket_head[bucket] = SPATIAL_END;
+	}
+}
+
+void spatial_insert(uint8_t slot) {
+	uint8_t bucket = SPATIAL_BUCKET(GET_X_POSITION(entity_position[slot]));
+
+	spatial_next[slot] = bucket_head[bucket];
+	bucket_head[bucket] = slot;
+}
+
+void spatial_remove(uint8_t slot) {
+	uint8_t* link = &bucket_head[SPATIAL_BUCKET(GET_X_POSITION(entity_position[slot]))];
+
+	// Find the link which points at this slot and skip over it
+	while(*link != SPATIAL_END) {
+		if(*link == slot) {
+			*link = spatial_next[slot];
+			return;
+		}
+		link = &spatial_next[*link];
+	}
+}
+
+uint8_t spatial_first(uint8_t bucket) {
+	return bucket_head[bucket];
+}
@@ -0,0 +1,45 @@
+/*
+ * spatial.h
+ *
+ * Author: Matt Burton
+ *
+ * An index of the entities (see entity.h) by field column. The field is
+ * split into buckets of SPATIAL_BUCKET_WIDTH columns and each bucket has
+ * a list of the entities whose left-most column is in it, so finding
+ * what is near a position only means looking at one or two short lists
+ * rather than every entity. Entities are indexed by the x value of 
+ * their position when they are inserted - asteroids and projectiles 
+ * never move sideways.
+ *
+ * To visit the entities in a bucket:
+ *
+ *	for(slot = spatial_first(bucket); slot != SPATIAL_END; 
+ *			slot = spatial_next[slot]) {
+ *		...
+ *	}
+ */
+
+#ifndef SPATIAL_H_
+#define SPATIAL_H_
+
+#include <stdint.h>
+#include "entity.h"
+
+#define SPATIAL_BUCKET_WIDTH	8
+#define SPATIAL_NUM_BUCKETS		(FIELD_WIDTH / SPATIAL_BUCKET_WIDTH)
+#define SPATIAL_BUCKET(x)		((uint8_t)(x) / SPATIAL_BUCKET_WIDTH)
+#define SPATIAL_END				0xFF
+
+extern uint8_t spatial_next[MAX_ENTITIES];
+
+// Empty every bucket.
+void spatial_clear(void);
+
+// Add/remove the entity in the given slot.
+void spatial_insert(uint8_t slot);
+void spatial_remove(uint8_t slot);
+
+// The first entity in a bucket, or SPATIAL_END if it is empty.
+uint8_t spatial_first(uint8_t bucket);
+
+#endif /* SPATIAL_H_ */
@@ -0,0 +1,168 @@
+/*
+ * sprite.c
+ *
+ * Written by Matt Burton
+ */
+
+#include "sprite.h"
+#include "framebuffer.h"
+#include "game.h"
+#include <avr/pgmspace.h>
+
+/* The base station - three wide on the bottom row with a single
+ * pixel above the centre.
+ */
+static const uint8_t base_rows[] PROGMEM = {0b111, 0b010};
+
+const Sprite sprite_base PROGMEM = {
+	3, 2, base_rows, base_rows, 0
+};
+
+/* Explosion frames - 3 x 3, centred on the middle column. The whole
+ * 3 x 3 block is covered so the frames erase whatever is under them.
+ */
+static const uint8_t explosion_mask[] PROGMEM = {0b111, 0b111, 0b111};
+static const uint8_t explosion_0[] PROGMEM = {0b010, 0b111, 0b010};
+static const uint8_t explosion_1[] PROGMEM = {0b101, 0b010, 0b101};
+static const PixelColour explosion_0_colours[] PROGMEM = {
+	COLOUR_BLACK, COLOUR_ORANGE, COLOUR_BLACK,
+	COLOUR_ORANGE, COLOUR_YELLOW, COLOUR_ORANGE,
+	COLOUR_BLACK, COLOUR_ORANGE, COLOUR_BLACK
+};
+static const PixelColour explosion_1_colours[] PROGMEM = {
+	COLOUR_RED, COLOUR_BLACK, COLOUR_RED,
+	COLOUR_BLACK, COLOUR_LIGHT_ORANGE, COLOUR_BLACK,
+	COLOUR_RED, COLOUR_BLACK, COLOUR_RED
+};
+
+const Sprite sprite_explosion[NUM_EXPLOSION_FRAMES] PROGMEM = {
+	{3, 3, explosion_0, explosion_mask, explosion_0_colours},
+	{3, 3, explosion_1, explosion_mask, explosion_1_colours}
+};
+
+/* Asteroids - a single cell, a pair, a 2 x 2 block and an L. Asteroids
+ * are drawn in one colour so the bitmap is the mask.
+ */
+static const uint8_t asteroid_single[] PROGMEM = {0b1};
+static const uint8_t asteroid_pair[] PROGMEM = {0b11};
+static const uint8_t asteroid_block[] PROGMEM = {0b11, 0b11};
+static const uint8_t asteroid_ell[] PROGMEM = {0b11, 0b01};
+
+const Sprite sprite_asteroid[NUM_ASTEROID_SHAPES] PROGMEM = {
+	{1, 1, asteroid_single, asteroid_single, 0},
+	{2, 1, asteroid_pair, asteroid_pair, 0},
+	{2, 2, asteroid_block, asteroid_block, 0},
+	{2, 2, asteroid_ell, asteroid_ell, 0}
+};
+
+// Clear the bits of a sprite row that fall off either side of the 
+// display when the sprite's left column is at game column x. (The 
+// display is always within the field, so this clips to the field too.)
+static uint8_t clip_row(uint8_t row, int8_t x) {
+	int16_t view_x = x - (int16_t)viewport_x;
+	
+	if(view_x < 0) {
+		// Columns 0 to -view_x-1 of the sprite are off the left edge
+		row = (view_x <= -8) ? 0 : row & (uint8_t)(0xFF << -view_x);
+	}
+	if(view_x > VIEW_WIDTH - 8) {
+		// Columns VIEW_WIDTH-view_x and beyond are off the right edge
+		row = (view_x >= VIEW_WIDTH) ? 0 : 
+				row & (uint8_t)(0xFF >> (view_x - (VIEW_WIDTH - 8)));
+	}
+	return row;
+}
+
+// Write one clipped sprite row to the framebuffer. The pixels of a row
+// on the display are ORIENTATION_GAME_X_STEP apart in the matrix (up to
+// the edge of a turned panel), so only the first pixel of each run has 
+// its address looked up.
+static void blit_row(const Sprite* s, uint8_t row, int8_t x, uint8_t y,
+		uint8_t covered, uint8_t lit, PixelColour colour) {
+	uint8_t col = 0;
+	uint8_t run, pixels, i;
+	uint16_t address;
+	
+	while(covered) {
+		if(!(covered & 1)) {
+			col++;
+			covered >>= 1;
+			lit >>= 1;
+			continue;
+		}
+		address = LED_MATRIX_ADDRESS_FROM_XY(x + col, y);
+		if(address == INVALID_MATRIX_ADDRESS) {
+			return;
+		}
+		// The columns left in this run
+		run = ORIENTATION_RUN_COLUMNS - 
+				(uint8_t)(x + col - viewport_x) % ORIENTATION_RUN_COLUMNS;
+		pixels = (run < 8) ? covered & (uint8_t)((1 << run) - 1) : covered;
+		if(!s->colours) {
+			framebuffer_set_line(address, ORIENTATION_GAME_X_STEP, pixels, lit, colour);
+		} else {
+			for(i = 0; pixels; i++, pixels >>= 1, 
+					address += ORIENTATION_GAME_X_STEP) {
+				if(!(pixels & 1)) {
+					continue;
+				}
+				framebuffer_set_address(address, ((lit >> i) & 1) ? 
+						pgm_read_byte(&s->colours[row * s->width + col + i]) : 
+						COLOUR_BLACK);
+			}
+		}
+		if(run >= 8) {
+			return;
+		}
+		col += run;
+		covered >>= run;
+		lit >>= run;
+	}
+}
+
+static void blit(const Sprite* sprite, int8_t x, int8_t y, PixelColour colour,
+		uint8_t erase) {
+	Sprite s;
+	int8_t gy;
+	uint8_t covered, lit;
+
+	// Take a RAM copy of the sprite header so we can use the plane pointers
+	memcpy_P(&s, sprite, sizeof(Sprite));
+	for(uint8_t row = 0; row < s.height; row++) {
+		gy = y + row;
+		if(gy < 0 || gy >= FIELD_HEIGHT) {
+			continue;
+		}
+		covered = clip_row(pgm_read_byte(&s.mask[row]), x);
+		lit = erase ? 0 : pgm_read_byte(&s.bitmap[row]);
+		if(covered) {
+			blit_row(&s, row, x, gy, covered, lit, colour);
+		}
+	}
+}
+
+void sprite_draw(const Sprite* sprite, int8_t x, int8_t y, PixelColour colour) {
+	blit(sprite, x, y, colour, 0);
+}
+
+void sprite_erase(const Sprite* sprite, int8_t x, int8_t y) {
+	blit(sprite, x, y, COLOUR_BLACK, 1);
+}
+
+uint8_t sprite_width(const Sprite* sprite) {
+	return pgm_read_byte(&sprite->width);
+}
+
+uint8_t sprite_height(const Sprite* sprite) {
+	return pgm_read_byte(&sprite->height);
+}
+
+uint8_t sprite_mask_row(const Sprite* sprite, uint8_t row) {
+	const uint8_t* mask;
+
+	if(row >= sprite_height(sprite)) {
+		return 0;
+	}
+	memcpy_P(&mask, &sprite->mask, sizeof(mask));
+	return pgm_read_byte(&mask[row]);
+}
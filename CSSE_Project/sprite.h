@@ -0,0 +1,61 @@
+/*
+ * sprite.h
+ *
+ * Author: Matt Burton
+ *
+ * Small bitmaps, stored in program memory, that can be drawn onto the
+ * game field with a single call. Sprites are drawn into the shadow
+ * framebuffer (see framebuffer.h) so they are only sent to the LED
+ * matrix on the next framebuffer_flush().
+ *
+ * A sprite is up to 8 columns wide. Each row of the sprite is one byte
+ * where bit n corresponds to column n of the sprite (counting from the
+ * left). Row 0 is the bottom row. Each sprite has
+ * - a mask plane - the pixels the sprite covers. Pixels outside the
+ *   mask are transparent and left unchanged.
+ * - a bitmap plane - the covered pixels which are lit. Covered pixels
+ *   which are not lit are drawn black.
+ * - an optional colour plane - one colour per pixel (width x height,
+ *   row by row). If this is 0 then all lit pixels are drawn in the
+ *   colour passed to sprite_draw().
+ */
+
+#ifndef SPRITE_H_
+#define SPRITE_H_
+
+#include <stdint.h>
+#include "pixel_colour.h"
+
+typedef struct {
+	uint8_t width;
+	uint8_t height;
+	const uint8_t* bitmap;
+	const uint8_t* mask;
+	const PixelColour* colours;
+} Sprite;
+
+// Sprites available to the game (these live in program memory and must
+// only be passed to the functions below).
+extern const Sprite sprite_base;
+#define NUM_EXPLOSION_FRAMES 2
+extern const Sprite sprite_explosion[NUM_EXPLOSION_FRAMES];
+// Asteroid shapes, indexed by the ASTEROID_* values in game.c
+#define NUM_ASTEROID_SHAPES 4
+extern const Sprite sprite_asteroid[NUM_ASTEROID_SHAPES];
+
+// Draw the sprite with its bottom left corner at game position (x,y).
+// Parts of the sprite that fall outside the game field are clipped, so
+// x and y may be negative. colour is used for lit pixels when the sprite
+// has no colour plane.
+void sprite_draw(const Sprite* sprite, int8_t x, int8_t y, PixelColour colour);
+
+// Set every pixel covered by the sprite's mask to black.
+void sprite_erase(const Sprite* sprite, int8_t x, int8_t y);
+
+// Read the size of a sprite, or one row of its mask plane (0 for rows
+// above the top of the sprite), from program memory.
+uint8_t sprite_width(const Sprite* sprite);
+uint8_t sprite_height(const Sprite* sprite);
+uint8_t sprite_mask_row(const Sprite* sprite, uint8_t row);
+
+#endif /* SPRITE_H_ */
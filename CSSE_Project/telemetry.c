@@ -0,0 +1,40 @@
+/*
+ * telemetry.c
+ *
+ * Written by Matt Burton
+ */
+
+#include "telemetry.h"
+#include "lockstep.h"
+#include "params.h"
+
+static uint8_t telemetry_on(void);
+
+void init_telemetry(void) {
+	init_serial_port(TELEMETRY_PORT, TELEMETRY_BAUD, 0);
+	serial_port_enable_output(TELEMETRY_PORT, 0);
+}
+
+int8_t telemetry_write(const uint8_t* data, uint8_t length) {
+	if(!telemetry_on()) {
+		return 0;
+	}
+	return serial_write_raw(TELEMETRY_PORT, data, length);
+}
+
+uint8_t telemetry_space(void) {
+	if(!telemetry_on()) {
+		return 0;
+	}
+	return serial_output_space(TELEMETRY_PORT);
+}
+
+// Turn the transmitter on or off to follow the parameter. (The link
+// turns it on and off itself - see lockstep.c.)
+static uint8_t telemetry_on(void) {
+	if(lockstep_active()) {
+		return 0;
+	}
+	serial_port_enable_output(TELEMETRY_PORT, param_get(PARAM_TELEMETRY));
+	return param_get(PARAM_TELEMETRY);
+}
@@ -0,0 +1,38 @@
+/*
+ * telemetry.h
+ *
+ * Author: Matt Burton
+ *
+ * Binary diagnostic output (log records - see log.h - and the display
+ * stream - see framestream.h) goes out on serial port 1 at 
+ * TELEMETRY_BAUD, so it doesn't compete with the terminal on port 0. 
+ * Port 1 is also the link to a second board in two player mode, so 
+ * nothing is sent while two player mode is active.
+ *
+ * Port 1's transmit pin (TXD1, PD3) is also the seven segment display's
+ * digit select (see seven_seg.c), so the transmitter is only on while
+ * the telemetry parameter (PARAM_TELEMETRY - see params.h) is on, or 
+ * while the link is in use (see lockstep.h). The seven segment display
+ * only shows one digit properly then. The parameter is off by default.
+ */
+
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+#include <stdint.h>
+#include "serialio.h"
+
+#define TELEMETRY_PORT	SERIAL_PORT1
+#define TELEMETRY_BAUD	76800
+
+void init_telemetry(void);
+
+// Queue data to be sent - all of it, or (if there isn't room, telemetry
+// is off or port 1 is in use by two player mode) none of it. Returns 1
+// if it was queued.
+int8_t telemetry_write(const uint8_t* data, uint8_t length);
+
+// The number of bytes that can be queued now (0 if none can be).
+uint8_t telemetry_space(void);
+
+#endif /* TELEMETRY_H_ */
@@ -0,0 +1,138 @@
+/*
+ * termui.c
+ *
+ * Written by Matt Burton
+ */
+
+#include <stdio.h>
+#include <avr/pgmspace.h>
+
+#include "termui.h"
+#include "terminalio.h"
+#include "serialio.h"
+#include "score.h"
+#include "lives.h"
+#include "game.h"
+
+// Header field columns
+#define TITLE_COLUMN	2
+#define SCORE_COLUMN	14
+#define LIVES_COLUMN	28
+#define LEVEL_COLUMN	38
+#define FPS_COLUMN		50
+
+// Each quarter of normal speed the asteroids gain is a level
+#define LEVEL_STEP		(ASTEROID_SPEED_SCALE_NORMAL / 4)
+
+#define FPS_INTERVAL_MS	1000
+
+typedef struct {
+	const char* format;
+	uint16_t a;
+} Event;
+
+// The queue of events waiting to be drawn
+static Event events[TERMUI_EVENT_QUEUE];
+static uint8_t first_event;
+static uint8_t num_events;
+
+// The header values as last drawn
+static uint8_t drawn_score_version;
+static uint8_t drawn_lives_version;
+static uint8_t drawn_level;
+static uint16_t drawn_fps;
+
+// Display frames counted since fps_start_time, and the rate over the
+// last whole interval
+static uint16_t frames;
+static uint16_t fps;
+static uint32_t fps_start_time;
+
+static uint8_t current_level(void);
+
+void termui_init(void) {
+	clear_terminal();
+	move_cursor(TITLE_COLUMN, TERMUI_HEADER_ROW);
+	printf_P(PSTR("Asteroids"));
+	set_scroll_region(TERMUI_LOG_TOP, TERMUI_LOG_BOTTOM);
+	
+	drawn_score_version = get_score_version() - 1;
+	drawn_lives_version = get_lives_version() - 1;
+	drawn_level = 0;
+	drawn_fps = 0xFFFF;
+	num_events = 0;
+}
+
+void termui_event(const char* format, uint16_t a) {
+	Event* event;
+	
+	if(num_events == TERMUI_EVENT_QUEUE) {
+		return;
+	}
+	event = &events[(first_event + num_events) % TERMUI_EVENT_QUEUE];
+	event->format = format;
+	event->a = a;
+	num_events++;
+}
+
+void termui_update(uint32_t current_time, uint8_t new_frame) {
+	uint8_t level;
+	
+	if(new_frame) {
+		frames++;
+	}
+	if(current_time >= fps_start_time + FPS_INTERVAL_MS) {
+		fps = frames * 1000UL / (current_time - fps_start_time);
+		frames = 0;
+		fps_start_time = current_time;
+	}
+	
+	// Each item is only drawn if there's room for it in the output 
+	// buffer - otherwise it waits for a later call
+	if(drawn_score_version != get_score_version() &&
+			serial_output_space(SERIAL_PORT0) >= TERMUI_MIN_SPACE) {
+		drawn_score_version = get_score_version();
+		move_cursor(SCORE_COLUMN, TERMUI_HEADER_ROW);
+		printf_P(PSTR("Score: %-5u"), get_score());
+	}
+	if(drawn_lives_version != get_lives_version() &&
+			serial_output_space(SERIAL_PORT0) >= TERMUI_MIN_SPACE) {
+		drawn_lives_version = get_lives_version();
+		move_cursor(LIVES_COLUMN, TERMUI_HEADER_ROW);
+		printf_P(PSTR("Lives: %u"), get_lives());
+	}
+	level = current_level();
+	if(drawn_level != level &&
+			serial_output_space(SERIAL_PORT0) >= TERMUI_MIN_SPACE) {
+		drawn_level = level;
+		move_cursor(LEVEL_COLUMN, TERMUI_HEADER_ROW);
+		printf_P(PSTR("Level: %-2u"), level);
+	}
+	if(drawn_fps != fps &&
+			serial_output_space(SERIAL_PORT0) >= TERMUI_MIN_SPACE) {
+		drawn_fps = fps;
+		move_cursor(FPS_COLUMN, TERMUI_HEADER_ROW);
+		printf_P(PSTR("FPS: %-4u"), fps);
+	}
+	
+	// Add events to the bottom of the log, scrolling the older ones up
+	for(uint8_t i = 0; i < TERMUI_EVENTS_PER_UPDATE && num_events > 0; i++) {
+		if(serial_output_space(SERIAL_PORT0) < TERMUI_MIN_SPACE) {
+			break;
+		}
+		move_cursor(1, TERMUI_LOG_BOTTOM);
+		scroll_up();
+		printf_P(events[first_event].format, events[first_event].a);
+		first_event = (first_event + 1) % TERMUI_EVENT_QUEUE;
+		num_events--;
+	}
+}
+
+static uint8_t current_level(void) {
+	uint16_t scale = get_asteroid_speed_scale();
+	
+	if(scale <= ASTEROID_SPEED_SCALE_NORMAL) {
+		return 1;
+	}
+	return 1 + (scale - ASTEROID_SPEED_SCALE_NORMAL) / LEVEL_STEP;
+}
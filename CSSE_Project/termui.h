@@ -0,0 +1,50 @@
+/*
+ * termui.h
+ *
+ * Author: Matt Burton
+ *
+ * The layout of the serial terminal during a game:
+ *	row TERMUI_HEADER_ROW		title, score, lives, level and frame rate
+ *	rows TERMUI_LOG_TOP to		the event log - the newest event at the
+ *	  TERMUI_LOG_BOTTOM			bottom, older ones scrolling up
+ *	row SHELL_ROW onwards		the command shell (see shell.h)
+ * with the display mirror (see termview.h) between the header and the 
+ * log.
+ *
+ * Header fields are only redrawn when they change. The log is a scroll
+ * region, so adding an event costs the terminal's scroll command and
+ * the new line - the same however long the log has been going - rather
+ * than redrawing the lines above it. Events are queued by 
+ * termui_event() and drawn by termui_update(), at most 
+ * TERMUI_EVENTS_PER_UPDATE at a time, and nothing is drawn unless there
+ * are TERMUI_MIN_SPACE bytes free in the serial output buffer - so the 
+ * terminal output never holds up the game.
+ */
+
+#ifndef TERMUI_H_
+#define TERMUI_H_
+
+#include <stdint.h>
+
+#define TERMUI_HEADER_ROW			1
+#define TERMUI_LOG_TOP				12
+#define TERMUI_LOG_BOTTOM			17
+#define TERMUI_EVENT_QUEUE			3
+#define TERMUI_EVENTS_PER_UPDATE	1
+#define TERMUI_MIN_SPACE			64
+
+// Clear the terminal and set up the layout for a new game.
+void termui_init(void);
+
+// Queue an event for the log. format is a printf format string in 
+// program memory (e.g. PSTR("...")) taking at most one unsigned 
+// argument (%u). Events which arrive when the queue is full are 
+// dropped - the queue holds the three handle_game_over() sends at once.
+void termui_event(const char* format, uint16_t a);
+
+// Call every time through the main loop. new_frame is non-zero if the
+// display has changed since the last call (this is what the frame rate
+// counts).
+void termui_update(uint32_t current_time, uint8_t new_frame);
+
+#endif /* TERMUI_H_ */
@@ -0,0 +1,247 @@
+/*
+ * termview.c
+ *
+ * Written by Matt Burton
+ */
+
+#include "termview.h"
+#include "framebuffer.h"
+#include "ledmatrix.h"
+#include "serialio.h"
+
+// Cell colours, as the last digit of the background colour escape 
+// sequences (except black, which is the terminal's normal background)
+#define CELL_BLACK		0
+#define CELL_RED		1
+#define CELL_GREEN		2
+#define CELL_YELLOW		3
+
+// The longest a single cell can take: an absolute move (ESC [ row ; col
+// H), a colour (ESC [ 4 n m) and the cell itself. The frame always ends
+// by setting the colour back to normal (ESC [ 0 m).
+#define MAX_MOVE_BYTES	10
+#define MAX_CELL_BYTES	(MAX_MOVE_BYTES + 5 + TERMVIEW_CELL_WIDTH)
+#define RESET_BYTES		4
+
+// showing is set while any cell may not be black
+static uint8_t enabled;
+static uint8_t showing;
+static uint32_t next_frame_time;
+
+static uint8_t frame_bytes;
+static uint32_t total_bytes;
+static uint16_t deferred_frames;
+
+// Where the cursor is (0 if we don't know) and the colour it is drawing
+// in, as the frame is put together
+static uint8_t cursor_row;
+static uint8_t cursor_column;
+static uint8_t cursor_colour;
+
+static void mark_lit(uint8_t keep);
+static uint8_t cell_colour(PixelColour colour);
+static uint8_t add_move(uint8_t* buffer, uint8_t length, uint8_t row, uint8_t column);
+static uint8_t add_sequence(uint8_t* buffer, uint8_t length, uint8_t number, char command);
+static uint8_t add_number(uint8_t* buffer, uint8_t length, uint8_t number);
+static uint8_t digits(uint8_t number);
+
+void termview_enable(uint8_t enable) {
+	// Turning on, the view is blank and only the lit pixels need drawing.
+	// Turning off, anything lit may have been drawn and has to be 
+	// blanked, as well as anything still waiting.
+	if(enable != enabled) {
+		mark_lit(!enable);
+	}
+	enabled = enable;
+	if(enabled) {
+		showing = 1;
+	}
+	frame_bytes = 0;
+	total_bytes = 0;
+	deferred_frames = 0;
+}
+
+uint8_t termview_enabled(void) {
+	return enabled;
+}
+
+void termview_invalidate(void) {
+	mark_lit(0);
+	showing = enabled;
+}
+
+void termview_update(uint32_t current_time) {
+	uint8_t cell[MAX_CELL_BYTES];
+	uint8_t limit = serial_output_space(SERIAL_PORT0);
+	uint8_t length = 0;
+	uint8_t cell_length, colour, row, column, unsent;
+	uint8_t complete = 1;
+	
+	if(!showing || current_time < next_frame_time) {
+		return;
+	}
+	next_frame_time = current_time + TERMVIEW_FRAME_MS;
+	frame_bytes = 0;
+	
+	if(limit < TERMVIEW_RESERVE + MAX_CELL_BYTES + RESET_BYTES) {
+		deferred_frames++;
+		return;
+	}
+	limit -= TERMVIEW_RESERVE;
+	if(limit > TERMVIEW_MAX_BYTES) {
+		limit = TERMVIEW_MAX_BYTES;
+	}
+	limit -= RESET_BYTES;
+	
+	// Other output has moved the cursor since the last frame, and left
+	// the colour normal
+	cursor_row = 0;
+	cursor_colour = CELL_BLACK;
+	
+	// Each cell goes straight into the output buffer (which has room for
+	// the whole frame), so only one cell is held here at a time
+	for(uint8_t y = MATRIX_NUM_ROWS; y-- > 0 && complete; ) {
+		for(uint8_t x = 0; x < MATRIX_TOTAL_COLUMNS; x++) {
+			unsent = framebuffer_unsent(VIEWER_TERMINAL, x);
+			if(!(unsent & (1 << y))) {
+				continue;
+			}
+			colour = enabled ? cell_colour(framebuffer_get_pixel(x, y)) : CELL_BLACK;
+			row = TERMVIEW_ROW + MATRIX_NUM_ROWS - 1 - y;
+			column = TERMVIEW_COLUMN + x * TERMVIEW_CELL_WIDTH;
+			
+			cell_length = add_move(cell, 0, row, column);
+			if(colour != cursor_colour) {
+				cell_length = add_sequence(cell, cell_length, 
+						colour == CELL_BLACK ? 0 : 40 + colour, 'm');
+			}
+			for(uint8_t i = 0; i < TERMVIEW_CELL_WIDTH; i++) {
+				cell[cell_length++] = ' ';
+			}
+			if(length + cell_length > limit) {
+				// Doesn't fit - leave it (and the rest) for the next frame
+				complete = 0;
+				break;
+			}
+			(void)serial_write_raw(SERIAL_PORT0, cell, cell_length);
+			length += cell_length;
+			cursor_row = row;
+			cursor_column = column + TERMVIEW_CELL_WIDTH;
+			cursor_colour = colour;
+			framebuffer_set_unsent(VIEWER_TERMINAL, x, unsent & ~(1 << y));
+		}
+	}
+	if(cursor_colour != CELL_BLACK) {
+		cell_length = add_sequence(cell, 0, 0, 'm');
+		(void)serial_write_raw(SERIAL_PORT0, cell, cell_length);
+		length += cell_length;
+	}
+	if(!complete) {
+		deferred_frames++;
+	} else if(!enabled) {
+		showing = 0;
+	}
+	frame_bytes = length;
+	total_bytes += length;
+}
+
+uint8_t termview_frame_bytes(void) {
+	return frame_bytes;
+}
+
+uint32_t termview_total_bytes(void) {
+	return total_bytes;
+}
+
+uint16_t termview_deferred_frames(void) {
+	return deferred_frames;
+}
+
+// Mark the lit pixels as needing to be drawn - as well as those already
+// waiting if keep is set (otherwise they are forgotten).
+static void mark_lit(uint8_t keep) {
+	uint8_t lit;
+	
+	for(uint8_t x = 0; x < MATRIX_TOTAL_COLUMNS; x++) {
+		lit = keep ? framebuffer_unsent(VIEWER_TERMINAL, x) : 0;
+		for(uint8_t y = 0; y < MATRIX_NUM_ROWS; y++) {
+			if(framebuffer_get_pixel(x, y) != COLOUR_BLACK) {
+				lit |= (1 << y);
+			}
+		}
+		framebuffer_set_unsent(VIEWER_TERMINAL, x, lit);
+	}
+}
+
+// The terminal colour to show a pixel colour (4 bits each of red and 
+// green) as - whichever of red and green is clearly the brighter, or 
+// yellow if they are close.
+static uint8_t cell_colour(PixelColour colour) {
+	uint8_t red = colour & 0x0F;
+	uint8_t green = colour >> 4;
+	
+	if(red == 0 && green == 0) {
+		return CELL_BLACK;
+	} else if(red >= 2 * green) {
+		return CELL_RED;
+	} else if(green >= 2 * red) {
+		return CELL_GREEN;
+	}
+	return CELL_YELLOW;
+}
+
+// Move the cursor from where it is to row, column - relative to where it
+// is if we know that and it's shorter.
+static uint8_t add_move(uint8_t* buffer, uint8_t length, uint8_t row, uint8_t column) {
+	uint8_t start = length;
+	uint8_t absolute_bytes = 4 + digits(row) + digits(column);
+	
+	if(cursor_row != 0 && row >= cursor_row) {
+		if(row > cursor_row) {
+			length = add_sequence(buffer, length, row - cursor_row, 'B');
+		}
+		if(column > cursor_column) {
+			length = add_sequence(buffer, length, column - cursor_column, 'C');
+		} else if(column < cursor_column) {
+			length = add_sequence(buffer, length, cursor_column - column, 'D');
+		}
+		if(length - start <= absolute_bytes) {
+			return length;
+		}
+		length = start;
+	}
+	buffer[length++] = '\x1b';
+	buffer[length++] = '[';
+	length = add_number(buffer, length, row);
+	buffer[length++] = ';';
+	length = add_number(buffer, length, column);
+	buffer[length++] = 'H';
+	return length;
+}
+
+// ESC [ number command - the number is left out if it is 1 (which is 
+// what the terminal takes it to be anyway)
+static uint8_t add_sequence(uint8_t* buffer, uint8_t length, uint8_t number, char command) {
+	buffer[length++] = '\x1b';
+	buffer[length++] = '[';
+	if(number != 1) {
+		length = add_number(buffer, length, number);
+	}
+	buffer[length++] = command;
+	return length;
+}
+
+static uint8_t add_number(uint8_t* buffer, uint8_t length, uint8_t number) {
+	if(number >= 100) {
+		buffer[length++] = '0' + number / 100;
+	}
+	if(number >= 10) {
+		buffer[length++] = '0' + (number / 10) % 10;
+	}
+	buffer[length++] = '0' + number % 10;
+	return length;
+}
+
+static uint8_t digits(uint8_t number) {
+	return number >= 100 ? 3 : number >= 10 ? 2 : 1;
+}
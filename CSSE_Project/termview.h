@@ -0,0 +1,50 @@
+/*
+ * termview.h
+ *
+ * Author: Matt Burton
+ *
+ * Mirrors the LED matrix on the serial terminal, as coloured blocks 
+ * (each TERMVIEW_CELL_WIDTH characters wide) with the top left corner at
+ * TERMVIEW_COLUMN, TERMVIEW_ROW - laid out as the matrix is, row 7 at 
+ * the top (see ledmatrix.h). Colours are shown as black, red, green or
+ * yellow.
+ *
+ * Every TERMVIEW_FRAME_MS the cells whose pixels have changed colour 
+ * since they were last drawn (which the framebuffer keeps track of - 
+ * see framebuffer_unsent()) are drawn, using relative cursor moves 
+ * between them. A frame is limited to TERMVIEW_MAX_BYTES, and to the 
+ * free space in the terminal's output buffer less TERMVIEW_RESERVE (so
+ * the rest of the terminal output never has to wait for it). Cells 
+ * which don't fit are drawn in a later frame.
+ */
+
+#ifndef TERMVIEW_H_
+#define TERMVIEW_H_
+
+#include <stdint.h>
+
+#define TERMVIEW_COLUMN		30
+#define TERMVIEW_ROW		3
+#define TERMVIEW_CELL_WIDTH	2
+#define TERMVIEW_FRAME_MS	100
+#define TERMVIEW_MAX_BYTES	64
+#define TERMVIEW_RESERVE	64
+
+// Turning the view off blanks it (over the next few frames).
+void termview_enable(uint8_t enable);
+uint8_t termview_enabled(void);
+
+// The terminal has been cleared - everything has to be drawn again.
+void termview_invalidate(void);
+
+// Draw a frame if it's time to. Call after framebuffer_flush().
+void termview_update(uint32_t current_time);
+
+// The number of bytes sent for the last frame, the total sent since the
+// view was enabled, and the number of frames which couldn't draw all 
+// their changes.
+uint8_t termview_frame_bytes(void);
+uint32_t termview_total_bytes(void);
+uint16_t termview_deferred_frames(void);
+
+#endif /* TERMVIEW_H_ */
@@ -0,0 +1,45 @@
+/*
+ * viewport.c
+ *
+ * Written by Matt Burton
+ */
+
+#include "viewport.h"
+#include "framebuffer.h"
+#include "game.h"
+
+#define LAST_VIEWPORT_X	(FIELD_WIDTH - VIEW_WIDTH)
+
+uint8_t viewport_x;
+
+void viewport_centre(uint8_t x) {
+	if(x < VIEW_WIDTH / 2) {
+		viewport_x = 0;
+	} else if(x - VIEW_WIDTH / 2 > LAST_VIEWPORT_X) {
+		viewport_x = LAST_VIEWPORT_X;
+	} else {
+		viewport_x = x - VIEW_WIDTH / 2;
+	}
+}
+
+int8_t viewport_follow(uint8_t x) {
+	if(x < viewport_x + VIEWPORT_MARGIN && viewport_x > 0) {
+		viewport_x--;
+		framebuffer_shift(ORIENTATION_SHIFT_GAME_RIGHT);
+		return viewport_x;
+	}
+	if(x >= viewport_x + VIEW_WIDTH - VIEWPORT_MARGIN && viewport_x < LAST_VIEWPORT_X) {
+		viewport_x++;
+		framebuffer_shift(ORIENTATION_SHIFT_GAME_LEFT);
+		return viewport_x + VIEW_WIDTH - 1;
+	}
+	return -1;
+}
+
+uint16_t viewport_address(uint8_t x, uint8_t y) {
+	x -= viewport_x;
+	if(x >= VIEW_WIDTH || y >= VIEW_HEIGHT) {
+		return INVALID_MATRIX_ADDRESS;
+	}
+	return MATRIX_ADDRESS_FROM_GAME_XY(x, y);
+}
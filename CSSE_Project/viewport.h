@@ -0,0 +1,42 @@
+/*
+ * viewport.h
+ *
+ * Author: Matt Burton
+ *
+ * The game field can be wider than the LED matrix display (see 
+ * FIELD_WIDTH in game.h). The display shows VIEW_WIDTH columns of the
+ * field starting at column viewport_x. Drawing is done in field 
+ * coordinates - viewport_address() turns a field position into the
+ * matrix address of the pixel showing it, or INVALID_MATRIX_ADDRESS if
+ * it is out of view (which the framebuffer ignores).
+ */
+
+#ifndef VIEWPORT_H_
+#define VIEWPORT_H_
+
+#include <stdint.h>
+#include "orientation.h"
+
+#define VIEW_WIDTH	ORIENTATION_FIELD_WIDTH
+#define VIEW_HEIGHT	ORIENTATION_FIELD_HEIGHT
+
+// The viewport scrolls to keep the column it is following at least this
+// many columns from either side of the display.
+#define VIEWPORT_MARGIN	2
+
+// The left-most field column on the display.
+extern uint8_t viewport_x;
+
+// Show the given column as close to the middle of the display as the
+// field allows. The display must be redrawn afterwards.
+void viewport_centre(uint8_t x);
+
+// Scroll the display (at most one column) so that column x is not within
+// VIEWPORT_MARGIN columns of either side. The display is shifted with 
+// framebuffer_shift() and the column that came into view is left black. 
+// Returns that column, or -1 if the display didn't scroll.
+int8_t viewport_follow(uint8_t x);
+
+uint16_t viewport_address(uint8_t x, uint8_t y);
+
+#endif /* VIEWPORT_H_ */
@@ -0,0 +1,52 @@
+/*
+ * advance_bench.c
+ *
+ * Written by Matt Burton
+ *
+ * Host benchmark of advance_asteroids(). The Makefile builds it against 
+ * the current tree and against two earlier revisions - the last one 
+ * which moved the asteroids in place (INPLACE_REV) and the one which 
+ * replaced that with the double buffered update (BUFFERED_REV) - so 
+ * the only difference between those two is the update. Only functions
+ * all three have are used.
+ *
+ * The game is started afresh every ROUND_TICKS ticks, with the asteroids
+ * at the fastest speed scale, so the field stays busy (asteroids which
+ * hit the base aren't replaced). Ticks in which the base is hit are
+ * left out, as the hit animation would swamp the update itself. The 
+ * game's own terminal output goes to stdout, the results to stderr.
+ */
+
+#include <stdio.h>
+#include "host.h"
+#include "game.h"
+#include "lives.h"
+
+#define BENCH_TICKS		200000UL
+#define ROUND_TICKS		50
+
+int main(void) {
+	uint64_t start, elapsed = 0;
+	uint32_t timed = 0;
+	uint8_t lives;
+	
+	ledmatrix_setup();
+	for(uint32_t tick = 0; tick < BENCH_TICKS; tick++) {
+		if(tick % ROUND_TICKS == 0) {
+			init_lives();
+			initialise_game();
+			set_asteroid_speed_scale(ASTEROID_SPEED_SCALE_MAX);
+		}
+		lives = get_lives();
+		start = host_microseconds();
+		advance_asteroids();
+		if(get_lives() == lives) {
+			elapsed += host_microseconds() - start;
+			timed++;
+		}
+	}
+	fprintf(stderr, "%s: %lu ticks (without a base hit) in %llu us: %.2f us/tick (host)\n",
+			BENCH_NAME, (unsigned long)timed, (unsigned long long)elapsed, 
+			(double)elapsed / timed);
+	return 0;
+}
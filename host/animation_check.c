@@ -0,0 +1,87 @@
+/*
+ * animation_check.c
+ *
+ * Written by Matt Burton
+ *
+ * Host check of animation.c - the shift steps must leave the simulated
+ * panels showing what the framebuffer's shadow copy holds, so that the
+ * framebuffer (and the display stream and terminal view, which work
+ * from it) stay in step with the display. The pixels are drawn on 
+ * every layer, at different brightnesses, so the layers must move with
+ * them. Also plays a text step, with its text in program memory, to the
+ * end.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <avr/pgmspace.h>
+#include "host.h"
+#include "timer0.h"
+#include "framebuffer.h"
+#include "palette.h"
+#include "animation.h"
+#include "orientation.h"
+
+static const AnimationStep shifts[] PROGMEM = {
+	{ANIM_SHIFT_RIGHT, 5, 100, 0, 0},
+	{ANIM_SHIFT_UP, 3, 100, 0, 0},
+	{ANIM_SHIFT_LEFT, 2, 100, 0, 0},
+	{ANIM_SHIFT_DOWN, 4, 100, 0, 0},
+	{ANIM_FADE, BRIGHTNESS_MAX / 3, 50, 0, 0},
+	{ANIM_SHIFT_RIGHT, MATRIX_NUM_COLUMNS, 100, 0, 0},
+	{ANIM_END, 0, 0, 0, 0}
+};
+
+static const char text[] PROGMEM = "GG";
+static const AnimationStep scroll[] PROGMEM = {
+	{ANIM_RESET, 0, 0, 0, 0},
+	{ANIM_SCROLL_TEXT, 0, 100, text, COLOUR_GREEN},
+	{ANIM_END, 0, 0, 0, 0}
+};
+
+int main(void) {
+	uint16_t failures = 0;
+	uint8_t lit = 0;
+	
+	ledmatrix_setup();
+	init_palette();
+	palette_set_layer_brightness(LAYER_BASE, BRIGHTNESS_MAX / 2);
+	palette_set_layer_brightness(LAYER_EFFECTS, BRIGHTNESS_MAX / 4);
+	framebuffer_clear();
+	srand(1);
+	for(uint8_t x = 0; x < MATRIX_TOTAL_COLUMNS; x++) {
+		for(uint8_t y = 0; y < MATRIX_NUM_ROWS; y++) {
+			framebuffer_select_layer((x + y) % NUM_LAYERS);
+			framebuffer_set_pixel(x, y, rand() % 256);
+		}
+	}
+	framebuffer_select_layer(LAYER_FIELD);
+	(void)framebuffer_flush();
+	
+	animation_start(shifts);
+	while(animation_step(get_current_time())) {
+		host_advance_time(10);
+		for(uint8_t x = 0; x < MATRIX_TOTAL_COLUMNS; x++) {
+			for(uint8_t y = 0; y < MATRIX_NUM_ROWS; y++) {
+				if(host_matrix_pixel(x, y) != palette_apply(framebuffer_get_pixel(x, y),
+						framebuffer_get_address_layer(MATRIX_ADDRESS(x, y)))) {
+					failures++;
+				}
+			}
+		}
+	}
+	
+	// The text should show and then scroll off (well within a minute)
+	animation_start(scroll);
+	while(animation_step(get_current_time()) && get_current_time() < 60000) {
+		for(uint8_t y = 0; y < MATRIX_NUM_ROWS; y++) {
+			lit |= host_matrix_pixel(MATRIX_NUM_COLUMNS - 1, y) != COLOUR_BLACK;
+		}
+		host_advance_time(10);
+	}
+	if(get_current_time() >= 60000 || !lit) {
+		failures++;
+	}
+	printf("%s: animation, %d panel(s)\n", failures ? "FAIL" : "ok", LEDMATRIX_NUM_PANELS);
+	return failures != 0;
+}
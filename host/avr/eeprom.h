@@ -0,0 +1,27 @@
+/*
+ * avr/eeprom.h (host)
+ *
+ * Written by Matt Burton
+ *
+ * EEMEM variables are ordinary variables on the host (in their own 
+ * section, as on the AVR, so ramsize.py can leave them out), and the 
+ * EEPROM functions (in host.c) just copy to and from them.
+ */
+
+#ifndef HOST_AVR_EEPROM_H_
+#define HOST_AVR_EEPROM_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define EEMEM	__attribute__((section(".eeprom")))
+
+uint8_t eeprom_read_byte(const uint8_t* address);
+uint16_t eeprom_read_word(const uint16_t* address);
+void eeprom_read_block(void* destination, const void* source, size_t length);
+void eeprom_update_byte(uint8_t* address, uint8_t value);
+void eeprom_update_word(uint16_t* address, uint16_t value);
+void eeprom_update_block(const void* source, void* destination, size_t length);
+#define eeprom_is_ready()	1
+
+#endif /* HOST_AVR_EEPROM_H_ */
@@ -0,0 +1,21 @@
+/*
+ * avr/interrupt.h (host)
+ *
+ * Written by Matt Burton
+ *
+ * Interrupt handlers become ordinary functions, which a host program 
+ * can call to play the part of the hardware. Interrupts are never 
+ * enabled, so SREG's I bit stays clear - serialio's output then drops 
+ * characters when its buffer is full rather than waiting for ever.
+ */
+
+#ifndef HOST_AVR_INTERRUPT_H_
+#define HOST_AVR_INTERRUPT_H_
+
+#include <avr/io.h>
+
+#define ISR(vector)	void vector(void)
+#define sei()		do { } while(0)
+#define cli()		do { } while(0)
+
+#endif /* HOST_AVR_INTERRUPT_H_ */
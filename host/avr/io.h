@@ -0,0 +1,149 @@
+/*
+ * avr/io.h (host)
+ *
+ * Written by Matt Burton
+ *
+ * Stand-in for avr-libc's header on the host. The registers the game 
+ * uses are plain variables (defined in host.c) and the bit numbers are
+ * the ATmega324A's, so code which sets and tests bits behaves as it 
+ * would on the board - except that nothing happens in hardware.
+ */
+
+#ifndef HOST_AVR_IO_H_
+#define HOST_AVR_IO_H_
+
+#include <stdint.h>
+
+#define HOST_REGISTERS(X8, X16) \
+	X8(PORTA) X8(PORTB) X8(PORTC) X8(PORTD) \
+	X8(DDRA) X8(DDRB) X8(DDRC) X8(DDRD) \
+	X8(PINA) X8(PINB) X8(PINC) X8(PIND) \
+	X8(SREG) \
+	X8(UCSR0A) X8(UCSR0B) X8(UCSR0C) X8(UDR0) \
+	X8(UCSR1A) X8(UCSR1B) X8(UCSR1C) X8(UDR1) \
+	X8(TCNT0) X8(OCR0A) X8(OCR0B) X8(TCCR0A) X8(TCCR0B) X8(TIMSK0) X8(TIFR0) \
+	X8(TCCR1A) X8(TCCR1B) \
+	X8(TCNT2) X8(OCR2A) X8(TCCR2A) X8(TCCR2B) X8(TIMSK2) X8(TIFR2) \
+	X8(PCICR) X8(PCIFR) X8(PCMSK1) \
+	X8(SPCR0) X8(SPSR0) X8(SPDR0) \
+	X8(ADMUX) \
+	X8(EECR) X8(EEDR) \
+	X16(UBRR0) X16(UBRR1) X16(ADC) X16(OCR1A) X16(OCR1B) X16(TCNT1) X16(EEAR)
+
+#define HOST_DECLARE8(r)	extern volatile uint8_t r;
+#define HOST_DECLARE16(r)	extern volatile uint16_t r;
+HOST_REGISTERS(HOST_DECLARE8, HOST_DECLARE16)
+
+// The ADC converts instantly - any access to ADCSRA finishes the 
+// conversion that was started (clearing ADSC), with ADC reading half
+// scale (so the joystick is centred).
+volatile uint8_t* host_adcsra(void);
+#define ADCSRA	(*host_adcsra())
+
+// SREG
+#define SREG_I	7
+
+// Ports
+#define PA0 0
+#define PA1 1
+#define PA2 2
+#define PA3 3
+#define PA4 4
+#define PA5 5
+#define PA6 6
+#define PA7 7
+
+// USART0 and USART1
+#define RXC0	7
+#define TXC0	6
+#define UDRE0	5
+#define FE0		4
+#define DOR0	3
+#define UPE0	2
+#define U2X0	1
+#define RXCIE0	7
+#define TXCIE0	6
+#define UDRIE0	5
+#define RXEN0	4
+#define TXEN0	3
+#define UCSZ01	2
+#define UCSZ00	1
+#define RXC1	7
+#define TXC1	6
+#define UDRE1	5
+#define FE1		4
+#define DOR1	3
+#define UPE1	2
+#define U2X1	1
+#define RXCIE1	7
+#define TXCIE1	6
+#define UDRIE1	5
+#define RXEN1	4
+#define TXEN1	3
+#define UCSZ11	2
+#define UCSZ10	1
+
+// Timers
+#define WGM01	1
+#define WGM00	0
+#define CS02	2
+#define CS01	1
+#define CS00	0
+#define OCIE0A	1
+#define OCF0A	1
+#define COM1B1	5
+#define COM1B0	4
+#define WGM11	1
+#define WGM10	0
+#define WGM13	4
+#define WGM12	3
+#define CS12	2
+#define CS11	1
+#define CS10	0
+#define WGM21	1
+#define CS22	2
+#define CS21	1
+#define CS20	0
+#define OCIE2A	1
+#define OCF2A	1
+
+// Pin change interrupts
+#define PCIE1	1
+#define PCIF1	1
+#define PCINT8	0
+#define PCINT9	1
+#define PCINT10	2
+#define PCINT11	3
+
+// SPI
+#define SPE0	6
+#define MSTR0	4
+#define SPR10	1
+#define SPR00	0
+#define SPIF0	7
+#define SPI2X0	0
+
+// ADC
+#define REFS0	6
+#define MUX4	4
+#define MUX3	3
+#define MUX2	2
+#define MUX1	1
+#define MUX0	0
+#define ADEN	7
+#define ADSC	6
+#define ADPS2	2
+#define ADPS1	1
+#define ADPS0	0
+
+// EEPROM
+#define EEMPE	2
+#define EEPE	1
+#define EERE	0
+#define E2END	1023
+
+#define _BV(bit)				(1 << (bit))
+#define bit_is_set(sfr, bit)	((sfr) & _BV(bit))
+#define bit_is_clear(sfr, bit)	(!((sfr) & _BV(bit)))
+
+#endif /* HOST_AVR_IO_H_ */
@@ -0,0 +1,40 @@
+/*
+ * avr/pgmspace.h (host)
+ *
+ * Written by Matt Burton
+ *
+ * Program memory is ordinary memory on the host, so the _P functions 
+ * are their ordinary versions and the pgm_read_ macros just read. 
+ * PROGMEM data (and PSTR() strings) still go in a section of their own,
+ * as on the AVR, so ramsize.py can leave them out.
+ */
+
+#ifndef HOST_AVR_PGMSPACE_H_
+#define HOST_AVR_PGMSPACE_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define PROGMEM				__attribute__((section(".progmem.data")))
+#define PSTR(s)				(__extension__({static const char __c[] PROGMEM = (s); &__c[0];}))
+#define PGM_P				const char*
+#define pgm_read_byte(p)	(*(const uint8_t*)(p))
+#define pgm_read_word(p)	(*(const uint16_t*)(p))
+#define pgm_read_dword(p)	(*(const uint32_t*)(p))
+#define pgm_read_ptr(p)		(*(void* const*)(p))
+#define printf_P			printf
+#define fprintf_P			fprintf
+#define sprintf_P			sprintf
+#define snprintf_P			snprintf
+#define vfprintf_P			vfprintf
+#define fputs_P				fputs
+#define puts_P				puts
+#define strcmp_P			strcmp
+#define strncmp_P			strncmp
+#define strcpy_P			strcpy
+#define strncpy_P			strncpy
+#define strlen_P			strlen
+#define memcpy_P			memcpy
+
+#endif /* HOST_AVR_PGMSPACE_H_ */
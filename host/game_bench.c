@@ -0,0 +1,140 @@
+/*
+ * game_bench.c
+ *
+ * Written by Matt Burton
+ *
+ * Headless host benchmark of the whole game, with the autopilot (see
+ * autopilot.h) as the player. GAMES games are played with project.c's
+ * new_game() and play_game(), each ending at game over or after GAME_MS
+ * of simulated time, and the host time taken per asteroid tick is
+ * reported. (The simulated clock moves on with every read of it - see
+ * host.h - so simulated time says how often the game read the clock,
+ * not how fast it ran.)
+ *
+ * Then the autopilot's decisions are timed on their own, on the fields
+ * of a game it plays, grouped by how many of the field's cells hold an
+ * asteroid. A decision reads every row and looks at most 
+ * AUTOPILOT_SEARCH columns either side of the base, so its time should
+ * not grow with the number of asteroids. The game's own terminal
+ * output goes to stdout, the results to stderr. The figures are for the
+ * host CPU, not the AVR.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "host.h"
+#include "timer0.h"
+#include "autopilot.h"
+#include "buttons.h"
+#include "game.h"
+#include "score.h"
+#include "lives.h"
+
+#define SEED			66
+#define GAMES			5
+#define GAME_MS			600000UL
+#define FIELDS			20000UL
+#define DECISIONS		200
+
+// Fields are grouped by the number of cells with an asteroid in them,
+// in steps of GROUP_SIZE
+#define GROUP_SIZE		16
+#define GROUPS			4
+
+// project.c
+void initialise_hardware(void);
+void new_game(void);
+void play_game(void);
+
+static void end_game(void) {
+	subtract_lives(get_lives());
+}
+
+// The number of field cells with an asteroid in them
+static uint16_t asteroid_cells(void) {
+	uint16_t count = 0;
+	FieldRow row;
+
+	for(uint8_t y = 0; y < FIELD_HEIGHT; y++) {
+		for(row = get_asteroid_row(y); row; row &= row - 1) {
+			count++;
+		}
+	}
+	return count;
+}
+
+int main(void) {
+	uint64_t start, elapsed, group_elapsed[GROUPS] = {0};
+	uint32_t ticks = 0, presses = 0, score = 0, simulated = 0;
+	uint32_t group_fields[GROUPS] = {0};
+	uint8_t group;
+	int8_t button = NO_BUTTON_PUSHED;
+
+	initialise_hardware();
+	srandom(SEED);
+
+	// The whole game
+	start = host_microseconds();
+	for(uint8_t game = 0; game < GAMES; game++) {
+		autopilot_set_mode(AUTOPILOT_ON);
+		host_set_time(0);
+		host_set_alarm(GAME_MS, end_game);
+		new_game();
+		play_game();
+		ticks += get_tick_number();
+		presses += autopilot_presses();
+		score += get_score();
+		simulated += get_current_time();
+	}
+	elapsed = host_microseconds() - start;
+	fprintf(stderr, "game: %u games, %lu ticks, %lu autopilot presses, %lu points "
+			"in %llu us: %.2f us/tick (host)\n", GAMES, (unsigned long)ticks,
+			(unsigned long)presses, (unsigned long)score,
+			(unsigned long long)elapsed, (double)elapsed / ticks);
+	fprintf(stderr, "game: %lu s of simulated time\n", (unsigned long)simulated / 1000);
+
+	// The autopilot's decisions on their own. Each field is decided on
+	// DECISIONS times (each decision is made afresh), then the decision
+	// is carried out and the game moved on.
+	init_lives();
+	initialise_game();
+	for(uint32_t field = 0; field < FIELDS; field++) {
+		if(get_lives() < 2) {
+			init_lives();
+			initialise_game();
+		}
+		group = asteroid_cells() / GROUP_SIZE;
+		if(group >= GROUPS) {
+			group = GROUPS - 1;
+		}
+		start = host_microseconds();
+		for(uint16_t i = 0; i < DECISIONS; i++) {
+			autopilot_set_mode(AUTOPILOT_ON);
+			button = autopilot_input(AUTOPILOT_INTERVAL_MS);
+		}
+		group_elapsed[group] += host_microseconds() - start;
+		group_fields[group]++;
+		if(button == 3) {
+			(void)move_base(MOVE_LEFT);
+		} else if(button == 0) {
+			(void)move_base(MOVE_RIGHT);
+		} else if(button == 2) {
+			(void)fire_projectile();
+		}
+		advance_projectiles();
+		if(field % 2 == 0) {
+			advance_asteroids();
+		}
+	}
+	for(group = 0; group < GROUPS; group++) {
+		if(!group_fields[group]) {
+			continue;
+		}
+		fprintf(stderr, "autopilot: %2u to %2u cells occupied, %6lu fields: "
+				"%.1f ns/decision (host)\n", group * GROUP_SIZE,
+				(group == GROUPS - 1) ? FIELD_HEIGHT * FIELD_WIDTH : 
+				(group + 1) * GROUP_SIZE - 1, (unsigned long)group_fields[group],
+				group_elapsed[group] * 1000.0 / group_fields[group] / DECISIONS);
+	}
+	return 0;
+}
@@ -0,0 +1,119 @@
+/*
+ * host.c
+ *
+ * Written by Matt Burton
+ *
+ * The AVR registers, simulated clock and EEPROM for host builds.
+ */
+
+#include <string.h>
+#include <time.h>
+#include <avr/io.h>
+#include <avr/eeprom.h>
+#include "host.h"
+#include "timer0.h"
+
+#define HOST_DEFINE8(r)		volatile uint8_t r;
+#define HOST_DEFINE16(r)	volatile uint16_t r;
+HOST_REGISTERS(HOST_DEFINE8, HOST_DEFINE16)
+
+static volatile uint8_t adcsra;
+
+volatile uint8_t* host_adcsra(void) {
+	if(adcsra & (1 << ADSC)) {
+		adcsra &= ~(1 << ADSC);
+		ADC = 512;
+	}
+	return &adcsra;
+}
+
+static uint32_t clock_ticks;
+static uint8_t clock_step = 1;
+static uint32_t alarm_time;
+static void (*alarm_function)(void);
+
+// With the wall clock, clock_ticks is the time at wall_start
+static uint8_t wall_speed;
+static uint64_t wall_start;
+
+static uint32_t wall_ms(void) {
+	return (host_microseconds() - wall_start) * wall_speed / 1000;
+}
+
+void host_set_time(uint32_t time) {
+	clock_ticks = wall_speed ? time - wall_ms() : time;
+}
+
+void host_advance_time(uint32_t ms) {
+	clock_ticks += ms;
+}
+
+void host_use_wall_clock(uint8_t speed) {
+	wall_start = host_microseconds();
+	wall_speed = speed;
+}
+
+void host_set_clock_step(uint8_t ms) {
+	clock_step = ms;
+}
+
+void host_set_alarm(uint32_t time, void (*function)(void)) {
+	alarm_time = time;
+	alarm_function = function;
+}
+
+void init_timer0(void) {
+	host_set_time(0);
+}
+
+void toggle_timer(void) {
+}
+
+uint32_t get_current_time(void) {
+	uint32_t time = wall_speed ? clock_ticks + wall_ms() : clock_ticks;
+	void (*function)(void) = alarm_function;
+	
+	if(!wall_speed) {
+		clock_ticks += clock_step;
+	}
+	if(function && time >= alarm_time) {
+		alarm_function = 0;
+		function();
+	}
+	return time;
+}
+
+void set_clock_ticks(uint32_t value) {
+	host_set_time(value);
+}
+
+uint64_t host_microseconds(void) {
+	struct timespec now;
+	
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+uint8_t eeprom_read_byte(const uint8_t* address) {
+	return *address;
+}
+
+uint16_t eeprom_read_word(const uint16_t* address) {
+	return *address;
+}
+
+void eeprom_read_block(void* destination, const void* source, size_t length) {
+	memcpy(destination, source, length);
+}
+
+void eeprom_update_byte(uint8_t* address, uint8_t value) {
+	*address = value;
+}
+
+void eeprom_update_word(uint16_t* address, uint16_t value) {
+	*address = value;
+}
+
+void eeprom_update_block(const void* source, void* destination, size_t length) {
+	memcpy(destination, source, length);
+}
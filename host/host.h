@@ -0,0 +1,52 @@
+/*
+ * host.h
+ *
+ * Author: Matt Burton
+ *
+ * Support for building parts of the game on a PC (see the Makefile in
+ * this directory). The game's millisecond clock (timer0.h) is simulated
+ * - it only moves as the program runs, not with the wall clock, so runs
+ * are repeatable. The LED matrix (ledmatrix.h) is simulated by 
+ * host_matrix.c, which keeps what each panel would be showing, and the
+ * serial ports (serialio.h) by host_serial.c, which passes their data
+ * to and from file descriptors.
+ */
+
+#ifndef HOST_H_
+#define HOST_H_
+
+#include <stdint.h>
+#include "ledmatrix.h"
+
+// The simulated clock. Each read of it (get_current_time()) moves it on
+// by the clock step, 1 ms unless changed, so code which waits for the 
+// clock to move on (e.g. the base hit animation) still finishes.
+void host_set_time(uint32_t time);
+void host_advance_time(uint32_t ms);
+void host_set_clock_step(uint8_t ms);
+
+// Run the simulated clock from the wall clock instead, speed times as 
+// fast, for programs which talk to another process in real time (see
+// lockstep_sim.c). The clock can still be set, and moved on.
+void host_use_wall_clock(uint8_t speed);
+
+// Call function (once) when the simulated clock reaches the given time,
+// as a timer interrupt would on the board - e.g. to end a game which 
+// would otherwise go on for ever.
+void host_set_alarm(uint32_t time, void (*function)(void));
+
+// What the simulated panels are showing, as combined display 
+// coordinates (as framebuffer.h uses), and the number of SPI bytes that 
+// would have been sent to them.
+PixelColour host_matrix_pixel(uint8_t x, uint8_t y);
+uint32_t host_matrix_bytes(void);
+
+// Connect a serial port (see serialio.h) to a file descriptor for input
+// and one for output. Port 0 starts connected to stdin and stdout, port
+// 1 to nothing (its output is thrown away).
+void host_serial_connect(uint8_t port, int input_fd, int output_fd);
+
+// Wall clock time in microseconds, for timing host runs.
+uint64_t host_microseconds(void);
+
+#endif /* HOST_H_ */
@@ -0,0 +1,147 @@
+/*
+ * host_matrix.c
+ *
+ * Written by Matt Burton
+ *
+ * A stand in for ledmatrix.c in host builds. Rather than sending SPI 
+ * commands it keeps what each panel would be showing, and counts the
+ * bytes the commands would have taken.
+ */
+
+#include "ledmatrix.h"
+#include "host.h"
+
+static PixelColour panels[LEDMATRIX_NUM_PANELS][MATRIX_NUM_COLUMNS][MATRIX_NUM_ROWS];
+static uint8_t selected_panel;
+static uint32_t bytes_sent;
+
+void ledmatrix_setup(void) {
+	selected_panel = 0;
+	ledmatrix_clear();
+	bytes_sent = 0;
+}
+
+void ledmatrix_select_panel(uint8_t panel) {
+	if(panel < LEDMATRIX_NUM_PANELS) {
+		selected_panel = panel;
+	}
+}
+
+void ledmatrix_update_all(MatrixData data) {
+	for(uint8_t x = 0; x < MATRIX_NUM_COLUMNS; x++) {
+		copy_matrix_column(data[x], panels[selected_panel][x]);
+	}
+	bytes_sent += 1 + MATRIX_NUM_COLUMNS * MATRIX_NUM_ROWS;
+}
+
+void ledmatrix_update_pixel(uint8_t x, uint8_t y, PixelColour pixel) {
+	if(x >= MATRIX_NUM_COLUMNS || y >= MATRIX_NUM_ROWS) {
+		return;
+	}
+	panels[selected_panel][x][y] = pixel;
+	bytes_sent += 3;
+}
+
+void ledmatrix_update_row(uint8_t y, MatrixRow row) {
+	if(y >= MATRIX_NUM_ROWS) {
+		return;
+	}
+	for(uint8_t x = 0; x < MATRIX_NUM_COLUMNS; x++) {
+		panels[selected_panel][x][y] = row[x];
+	}
+	bytes_sent += 2 + MATRIX_NUM_COLUMNS;
+}
+
+void ledmatrix_update_column(uint8_t x, MatrixColumn col) {
+	if(x >= MATRIX_NUM_COLUMNS) {
+		return;
+	}
+	copy_matrix_column(col, panels[selected_panel][x]);
+	bytes_sent += 2 + MATRIX_NUM_ROWS;
+}
+
+// Shift every panel by (dx,dy), bringing in black.
+static void shift_panels(int8_t dx, int8_t dy) {
+	PixelColour (*p)[MATRIX_NUM_ROWS];
+	int8_t fromx, fromy;
+	
+	for(uint8_t panel = 0; panel < LEDMATRIX_NUM_PANELS; panel++) {
+		p = panels[panel];
+		for(uint8_t i = 0; i < MATRIX_NUM_COLUMNS; i++) {
+			// Work away from the edge being shifted towards
+			uint8_t x = (dx > 0) ? MATRIX_NUM_COLUMNS - 1 - i : i;
+			for(uint8_t j = 0; j < MATRIX_NUM_ROWS; j++) {
+				uint8_t y = (dy > 0) ? MATRIX_NUM_ROWS - 1 - j : j;
+				fromx = x - dx;
+				fromy = y - dy;
+				if(fromx < 0 || fromx >= MATRIX_NUM_COLUMNS || 
+						fromy < 0 || fromy >= MATRIX_NUM_ROWS) {
+					p[x][y] = COLOUR_BLACK;
+				} else {
+					p[x][y] = p[fromx][fromy];
+				}
+			}
+		}
+		bytes_sent += 2;
+	}
+}
+
+void ledmatrix_shift_display_left(void) {
+	shift_panels(-1, 0);
+}
+
+void ledmatrix_shift_display_right(void) {
+	shift_panels(1, 0);
+}
+
+void ledmatrix_shift_display_up(void) {
+	shift_panels(0, 1);
+}
+
+void ledmatrix_shift_display_down(void) {
+	shift_panels(0, -1);
+}
+
+void ledmatrix_clear(void) {
+	for(uint8_t panel = 0; panel < LEDMATRIX_NUM_PANELS; panel++) {
+		for(uint8_t x = 0; x < MATRIX_NUM_COLUMNS; x++) {
+			set_matrix_column_to_colour(panels[panel][x], COLOUR_BLACK);
+		}
+		bytes_sent++;
+	}
+}
+
+void copy_matrix_column(MatrixColumn from, MatrixColumn to) {
+	for(uint8_t row = 0; row < MATRIX_NUM_ROWS; row++) {
+		to[row] = from[row];
+	}
+}
+
+void copy_matrix_row(MatrixRow from, MatrixRow to) {
+	for(uint8_t col = 0; col < MATRIX_NUM_COLUMNS; col++) {
+		to[col] = from[col];
+	}
+}
+
+void set_matrix_column_to_colour(MatrixColumn matrix_column, PixelColour colour) {
+	for(uint8_t row = 0; row < MATRIX_NUM_ROWS; row++) {
+		matrix_column[row] = colour;
+	}
+}
+
+void set_matrix_row_to_colour(MatrixRow matrix_row, PixelColour colour) {
+	for(uint8_t column = 0; column < MATRIX_NUM_COLUMNS; column++) {
+		matrix_row[column] = colour;
+	}
+}
+
+PixelColour host_matrix_pixel(uint8_t x, uint8_t y) {
+	if(x >= MATRIX_TOTAL_COLUMNS || y >= MATRIX_NUM_ROWS) {
+		return COLOUR_BLACK;
+	}
+	return panels[x / MATRIX_NUM_COLUMNS][x % MATRIX_NUM_COLUMNS][y];
+}
+
+uint32_t host_matrix_bytes(void) {
+	return bytes_sent;
+}
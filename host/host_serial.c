@@ -0,0 +1,142 @@
+/*
+ * host_serial.c
+ *
+ * Written by Matt Burton
+ *
+ * A stand in for serialio.c in host builds. Each port reads from and 
+ * writes to a file descriptor (see host_serial_connect()). Output is
+ * written straight away, so a port's output buffer is always empty, and
+ * input is read from the descriptor as the game asks for it. There is
+ * no echo or flow control.
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+#include <poll.h>
+#include "serialio.h"
+#include "host.h"
+
+typedef struct {
+	int input_fd;
+	int output_fd;
+	int16_t next;		// a character read ahead, or -1
+	uint8_t flow;
+	uint8_t output_on;
+	SerialStats stats;
+	FILE* stream;
+} HostPort;
+
+static HostPort ports[SERIAL_NUM_PORTS] = {
+	{0, 1, -1, SERIAL0_FLOW_CONTROL, 1, {0, 0, 0, 0, 0}, 0},
+	{-1, -1, -1, SERIAL1_FLOW_CONTROL, 1, {0, 0, 0, 0, 0}, 0}
+};
+
+static const uint8_t output_sizes[SERIAL_NUM_PORTS] = 
+		{SERIAL0_OUTPUT_BUFFER_SIZE, SERIAL1_OUTPUT_BUFFER_SIZE};
+
+void host_serial_connect(uint8_t port, int input_fd, int output_fd) {
+	ports[port].input_fd = input_fd;
+	ports[port].output_fd = output_fd;
+	ports[port].next = -1;
+	if(ports[port].stream) {
+		fclose(ports[port].stream);
+		ports[port].stream = 0;
+	}
+}
+
+// Read ahead one character, if one is waiting
+static void read_ahead(HostPort* p) {
+	struct pollfd waiting = {p->input_fd, POLLIN, 0};
+	uint8_t c;
+	
+	if(p->next >= 0 || p->input_fd < 0 || poll(&waiting, 1, 0) != 1) {
+		return;
+	}
+	if(read(p->input_fd, &c, 1) == 1) {
+		p->next = c;
+	}
+}
+
+void init_serial_port(uint8_t port, long baudrate, int8_t echo) {
+	ports[port].output_on = 1;
+}
+
+void serial_port_enable_output(uint8_t port, uint8_t enable) {
+	ports[port].output_on = enable;
+}
+
+void init_serial_stdio(long baudrate, int8_t echo) {
+}
+
+FILE* serial_port_stream(uint8_t port) {
+	if(port == SERIAL_PORT0) {
+		return stdout;
+	}
+	if(!ports[port].stream) {
+		ports[port].stream = fdopen(dup(ports[port].output_fd), "w");
+		setvbuf(ports[port].stream, 0, _IONBF, 0);
+	}
+	return ports[port].stream;
+}
+
+int8_t serial_port_input_available(uint8_t port) {
+	read_ahead(&ports[port]);
+	return ports[port].next >= 0;
+}
+
+int8_t serial_input_available(void) {
+	return serial_port_input_available(SERIAL_PORT0);
+}
+
+int16_t serial_read_raw(uint8_t port) {
+	int16_t c;
+	
+	read_ahead(&ports[port]);
+	c = ports[port].next;
+	ports[port].next = -1;
+	return c;
+}
+
+void clear_serial_port_input_buffer(uint8_t port) {
+	while(serial_read_raw(port) >= 0) {
+		ports[port].stats.discarded++;
+	}
+}
+
+void clear_serial_input_buffer(void) {
+	clear_serial_port_input_buffer(SERIAL_PORT0);
+}
+
+int8_t serial_write_raw(uint8_t port, const uint8_t* data, uint8_t length) {
+	if(!ports[port].output_on) {
+		return 0;
+	}
+	if(port == SERIAL_PORT0) {
+		fflush(stdout);
+	}
+	if(ports[port].output_fd >= 0 && 
+			write(ports[port].output_fd, data, length) != length) {
+		return 0;
+	}
+	return 1;
+}
+
+uint8_t serial_output_space(uint8_t port) {
+	return ports[port].output_on ? output_sizes[port] : 0;
+}
+
+void serial_port_set_flow(uint8_t port, uint8_t flow) {
+	ports[port].flow = flow;
+}
+
+uint8_t serial_port_flow(uint8_t port) {
+	return ports[port].flow;
+}
+
+void serial_port_get_stats(uint8_t port, SerialStats* stats) {
+	*stats = ports[port].stats;
+}
+
+void serial_port_clear_stats(uint8_t port) {
+	ports[port].stats = (SerialStats){0, 0, 0, 0, 0};
+}
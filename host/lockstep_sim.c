@@ -0,0 +1,149 @@
+/*
+ * lockstep_sim.c
+ *
+ * Written by Matt Burton
+ *
+ * Host simulation of a two player game (see lockstep.h). Two processes
+ * each run the game (project.c's new_game() and play_game()), with
+ * serial port 1 of each connected to the other through a pseudo
+ * terminal, as the boards' ports would be by a cable. One hosts the
+ * game and the other joins it; the joining board's player is the
+ * autopilot and the host's player does nothing, so the base is hit
+ * until the game is over. Each board's clock runs from the wall clock
+ * (SPEED times as fast), so the two boards run at their own pace, as
+ * real boards do. Before it hosts, the host board sends NOISE_BYTES of
+ * other data (as its telemetry might be), with a PACKET_START type 
+ * byte ('S') in every few; the joining board must not take any of it 
+ * for an invitation.
+ *
+ * The boards must both get to the end of the game, at the same frame,
+ * without finding a difference in their checksums, and must agree on
+ * the final checksum, the score and the number of base hits. Each
+ * board's terminal output is thrown away. Given a number, the clocks
+ * run that many times as fast instead.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <pty.h>
+#include <sys/wait.h>
+#include "host.h"
+#include "timer0.h"
+#include "lockstep.h"
+#include "autopilot.h"
+#include "params.h"
+#include "game.h"
+#include "score.h"
+#include "lives.h"
+
+#define SEED		2010
+#define SPEED		4
+#define BOARDS		2
+#define NOISE_BYTES	1024
+
+typedef struct {
+	uint8_t status;
+	uint8_t base_hits;
+	uint16_t frames;
+	uint16_t checksum;
+	uint32_t seed;
+	uint32_t score;
+	uint32_t ms;
+} Result;
+
+// project.c
+void initialise_hardware(void);
+void new_game(void);
+void play_game(void);
+
+// Play the game as one board, with port 1 on link_fd
+static void play(uint8_t host, int link_fd, uint8_t speed, Result* result) {
+	// The terminal output (port 0 is also stdout) is thrown away
+	(void)dup2(open("/dev/null", O_WRONLY), 1);
+	initialise_hardware();
+	host_use_wall_clock(speed);
+	host_serial_connect(SERIAL_PORT0, -1, 1);
+	host_serial_connect(LOCKSTEP_PORT, link_fd, link_fd);
+	if(host) {
+		srandom(SEED);
+		for(uint16_t i = 0; i < NOISE_BYTES; i++) {
+			uint8_t byte = (i % 8 == 0) ? 'S' : random();
+			(void)write(link_fd, &byte, 1);
+		}
+		while(!lockstep_host(SEED, param_get(PARAM_DIFFICULTY))) {
+		}
+	} else {
+		while(!lockstep_poll_join()) {
+		}
+		autopilot_set_mode(AUTOPILOT_ON);
+	}
+	new_game();
+	play_game();
+
+	result->status = lockstep_status();
+	result->base_hits = MAX_LIVES - get_lives();
+	result->frames = lockstep_frame();
+	result->checksum = get_game_checksum();
+	result->seed = lockstep_seed();
+	result->score = get_score();
+	result->ms = get_current_time();
+	lockstep_stop();
+}
+
+int main(int argc, char** argv) {
+	static const char* names[BOARDS] = {"host", "joining"};
+	uint8_t speed = (argc > 1) ? atoi(argv[1]) : SPEED;
+	Result results[BOARDS];
+	struct termios raw;
+	int link[BOARDS], results_pipe[2], status, failed;
+	pid_t joining;
+
+	if(openpty(&link[0], &link[1], 0, 0, 0) != 0 || pipe(results_pipe) != 0) {
+		perror("lockstep_sim");
+		return 1;
+	}
+	// The link passes bytes through untouched
+	tcgetattr(link[1], &raw);
+	cfmakeraw(&raw);
+	tcsetattr(link[1], TCSANOW, &raw);
+
+	joining = fork();
+	if(joining == 0) {
+		close(link[0]);
+		play(0, link[1], speed, &results[1]);
+		(void)write(results_pipe[1], &results[1], sizeof(Result));
+		exit(0);
+	}
+	close(link[1]);
+	play(1, link[0], speed, &results[0]);
+	if(read(results_pipe[0], &results[1], sizeof(Result)) != sizeof(Result) ||
+			waitpid(joining, &status, 0) != joining) {
+		fprintf(stderr, "FAIL: two player game, no result from the joining board\n");
+		return 1;
+	}
+
+	for(uint8_t board = 0; board < BOARDS; board++) {
+		fprintf(stderr, "%s board: status %u, %u frames, checksum %04x, score %lu, "
+				"%u base hits, %lu ms\n", names[board], results[board].status,
+				results[board].frames, results[board].checksum,
+				(unsigned long)results[board].score, results[board].base_hits,
+				(unsigned long)results[board].ms);
+	}
+	if(results[1].seed != SEED) {
+		fprintf(stderr, "FAIL: two player game, joined with seed %lu rather than %u\n",
+				(unsigned long)results[1].seed, SEED);
+		return 1;
+	}
+	failed = results[0].status != LOCKSTEP_OK || results[1].status != LOCKSTEP_OK ||
+			results[0].frames != results[1].frames ||
+			results[0].checksum != results[1].checksum ||
+			results[0].score != results[1].score ||
+			results[0].base_hits != results[1].base_hits;
+	fprintf(stderr, "%s: two player game, %u frames, %u base hits, checksums %s\n",
+			failed ? "FAIL" : "ok", results[0].frames, results[0].base_hits,
+			(results[0].checksum == results[1].checksum) ? "agree" : "differ");
+	return failed;
+}
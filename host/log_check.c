@@ -0,0 +1,76 @@
+/*
+ * log_check.c
+ *
+ * Written by Matt Burton
+ *
+ * Host check of the binary log (log.h). Every message in log_ids.h is
+ * logged once (with arguments ARG_A and ARG_B), the telemetry port's
+ * output is decoded as log_view.c would, and each record must come
+ * back as the message and arguments that were logged. A LOG_LEVEL_DEBUG
+ * call, below the default LOG_LEVEL, must send nothing.
+ *
+ * For each message the bytes sent are compared with what printf_P()
+ * would have sent for the same text (with a newline), and the format
+ * string's size is given - on the board it would have been in flash.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "host.h"
+#include "log.h"
+#include "telemetry.h"
+#include "telemetry_reader.h"
+#include "params.h"
+
+#define ARG_A	1234
+#define ARG_B	56
+
+int main(void) {
+	FILE* output = tmpfile();
+	TelemetryReader reader;
+	char text[128];
+	uint16_t record_bytes = 0, text_bytes = 0, format_bytes = 0;
+	uint8_t id = 0, bad = 0, length;
+	int c;
+
+	init_params();
+	init_telemetry();
+	host_serial_connect(TELEMETRY_PORT, -1, fileno(output));
+	(void)param_set(PARAM_TELEMETRY, 1);
+
+	LOG(LOG_LEVEL_DEBUG, LOG_GAME_START);
+	for(id = 0; id < NUM_LOG_MESSAGES; id++) {
+		log_write(id, log_message_args(id), ARG_A, ARG_B);
+	}
+
+	printf("%-46s %6s %7s %6s\n", "message", "record", "printf", "format");
+	rewind(output);
+	telemetry_reader_init(&reader);
+	id = 0;
+	while((c = getc(output)) != EOF) {
+		if(telemetry_reader_byte(&reader, c) != TELEMETRY_LOG) {
+			continue;
+		}
+		if(reader.log_id != id ||
+				(log_message_args(id) >= 1 && reader.log_args[0] != ARG_A) ||
+				(log_message_args(id) == 2 && reader.log_args[1] != ARG_B)) {
+			bad++;
+		}
+		length = telemetry_reader_log_text(&reader, text, sizeof(text)) + 1;
+		printf("%-46s %6u %7u %6u\n", log_message_format(reader.log_id),
+				2 + 2 * log_message_args(reader.log_id), length,
+				(unsigned)strlen(log_message_format(reader.log_id)) + 1);
+		record_bytes += 2 + 2 * log_message_args(reader.log_id);
+		text_bytes += length;
+		format_bytes += strlen(log_message_format(reader.log_id)) + 1;
+		id++;
+	}
+	printf("%u messages: %u record bytes against %u bytes of text (%.1f saved per "
+			"call), %u bytes of format strings not on the board\n", NUM_LOG_MESSAGES,
+			record_bytes, text_bytes, (double)(text_bytes - record_bytes) / NUM_LOG_MESSAGES,
+			format_bytes);
+	printf("%s: binary log, %u records decoded of %u, %u wrong, %lu bytes skipped\n",
+			(id != NUM_LOG_MESSAGES || bad || reader.skipped) ? "FAIL" : "ok",
+			id, NUM_LOG_MESSAGES, bad, (unsigned long)reader.skipped);
+	return id != NUM_LOG_MESSAGES || bad || reader.skipped;
+}
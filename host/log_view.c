@@ -0,0 +1,38 @@
+/*
+ * log_view.c
+ *
+ * Written by Matt Burton
+ *
+ * Host decoder for the board's log records (see log.h). Reads the
+ * board's telemetry (see telemetry.h) from a file or serial device, or
+ * from standard input, and prints each log record as text, using the
+ * format strings in log_ids.h - the board itself only sends the
+ * message ID and arguments. Display stream packets are passed over.
+ * With the board on /dev/ttyUSB1, for example:
+ *	stty -F /dev/ttyUSB1 76800 raw && ./log_view /dev/ttyUSB1
+ * (The board's telemetry parameter must be on.)
+ */
+
+#include <stdio.h>
+#include "telemetry_reader.h"
+
+int main(int argc, char** argv) {
+	FILE* input = stdin;
+	TelemetryReader reader;
+	char text[128];
+	int c;
+
+	if(argc > 1 && !(input = fopen(argv[1], "rb"))) {
+		perror(argv[1]);
+		return 1;
+	}
+	telemetry_reader_init(&reader);
+	while((c = getc(input)) != EOF) {
+		if(telemetry_reader_byte(&reader, c) == TELEMETRY_LOG) {
+			(void)telemetry_reader_log_text(&reader, text, sizeof(text));
+			printf("%s\n", text);
+			fflush(stdout);
+		}
+	}
+	return 0;
+}
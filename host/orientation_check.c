@@ -0,0 +1,155 @@
+/*
+ * orientation_check.c
+ *
+ * Written by Matt Burton
+ *
+ * Host check of the display mapping for one build configuration (set
+ * DISPLAY_ORIENTATION, DISPLAY_MIRRORED and LEDMATRIX_NUM_PANELS with 
+ * EXTRA=-D... - "make check" runs every combination). Checks that
+ * - every game cell in view has its own matrix pixel, and the pixels of
+ *   a run are ORIENTATION_GAME_X_STEP apart,
+ * - scrolling the viewport (a framebuffer_shift() and a redraw of the 
+ *   column brought into view) leaves the simulated panels showing the 
+ *   same as drawing the field from scratch, and
+ * - sprites drawn anywhere on the display cover the right pixels.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "host.h"
+#include "framebuffer.h"
+#include "palette.h"
+#include "viewport.h"
+#include "sprite.h"
+#include "game.h"
+
+static PixelColour field[FIELD_WIDTH][FIELD_HEIGHT];
+static uint16_t failures;
+
+static void fail(const char* what, int x, int y) {
+	if(failures++ < 10) {
+		printf("FAIL: %s at game (%d,%d), viewport %u\n", what, x, y, viewport_x);
+	}
+}
+
+static void draw_column(uint8_t x) {
+	for(uint8_t y = 0; y < FIELD_HEIGHT; y++) {
+		framebuffer_set_address(LED_MATRIX_ADDRESS_FROM_XY(x, y), field[x][y]);
+	}
+}
+
+static void check_addresses(void) {
+	static uint8_t used[MATRIX_TOTAL_COLUMNS][MATRIX_NUM_ROWS];
+	uint16_t address;
+	uint8_t mx, my;
+	
+	if(VIEW_WIDTH * VIEW_HEIGHT != MATRIX_TOTAL_COLUMNS * MATRIX_NUM_ROWS) {
+		fail("view size", VIEW_WIDTH, VIEW_HEIGHT);
+	}
+	for(uint8_t x = 0; x < VIEW_WIDTH; x++) {
+		for(uint8_t y = 0; y < VIEW_HEIGHT; y++) {
+			address = MATRIX_ADDRESS_FROM_GAME_XY(x, y);
+			mx = MATRIX_ADDRESS_X(address);
+			my = MATRIX_ADDRESS_Y(address);
+			if(mx >= MATRIX_TOTAL_COLUMNS || my >= MATRIX_NUM_ROWS || used[mx][my]++) {
+				fail("address", x, y);
+			}
+			if((x + 1) % ORIENTATION_RUN_COLUMNS != 0 && x + 1 < VIEW_WIDTH &&
+					(uint16_t)(address + ORIENTATION_GAME_X_STEP) != 
+					MATRIX_ADDRESS_FROM_GAME_XY(x + 1, y)) {
+				fail("run step", x, y);
+			}
+		}
+	}
+}
+
+// Compare the simulated panels with the field as seen from the viewport
+static void check_panels(const char* what) {
+	uint16_t address;
+	
+	for(uint8_t x = viewport_x; x < viewport_x + VIEW_WIDTH; x++) {
+		for(uint8_t y = 0; y < FIELD_HEIGHT; y++) {
+			address = LED_MATRIX_ADDRESS_FROM_XY(x, y);
+			if(host_matrix_pixel(MATRIX_ADDRESS_X(address), MATRIX_ADDRESS_Y(address)) 
+					!= field[x][y]) {
+				fail(what, x, y);
+			}
+		}
+	}
+}
+
+// Follow a base from one side of the field to the other and back
+static void check_scrolling(void) {
+	int8_t column;
+	
+	for(uint8_t x = 0; x < FIELD_WIDTH; x++) {
+		for(uint8_t y = 0; y < FIELD_HEIGHT; y++) {
+			field[x][y] = (rand() % 3) ? COLOUR_BLACK : 1 + rand() % 254;
+		}
+	}
+	framebuffer_clear();
+	viewport_centre(0);
+	for(uint8_t x = 0; x < VIEW_WIDTH; x++) {
+		draw_column(x);
+	}
+	(void)framebuffer_flush();
+	check_panels("initial draw");
+	for(int16_t x = 0; x < 2 * FIELD_WIDTH; x++) {
+		column = viewport_follow((x < FIELD_WIDTH) ? x : 2 * FIELD_WIDTH - 1 - x);
+		if(column >= 0) {
+			draw_column(column);
+		}
+		(void)framebuffer_flush();
+		check_panels("scroll");
+	}
+}
+
+// Draw each sprite at every position across the display (over a black 
+// display) and check each pixel it covers
+static void check_sprites(void) {
+	const Sprite* sprites[] = {&sprite_base, &sprite_explosion[0], 
+			&sprite_explosion[1], &sprite_asteroid[0], &sprite_asteroid[1],
+			&sprite_asteroid[2], &sprite_asteroid[3]};
+	const Sprite* s;
+	uint8_t lit, covered;
+	PixelColour want;
+	
+	viewport_centre(FIELD_WIDTH / 2);
+	for(uint8_t n = 0; n < sizeof(sprites) / sizeof(sprites[0]); n++) {
+		s = sprites[n];
+		for(int8_t x = viewport_x - 3; x < viewport_x + VIEW_WIDTH; x++) {
+			framebuffer_clear();
+			sprite_draw(s, x, 1, COLOUR_GREEN);
+			for(uint8_t gx = viewport_x; gx < viewport_x + VIEW_WIDTH; gx++) {
+				for(uint8_t gy = 0; gy < FIELD_HEIGHT; gy++) {
+					covered = gx >= x && gx < x + s->width && gy >= 1 && gy < 1 + s->height;
+					lit = covered && (s->bitmap[gy - 1] >> (gx - x)) & 1;
+					if(!lit) {
+						want = COLOUR_BLACK;
+					} else if(s->colours) {
+						want = s->colours[(gy - 1) * s->width + gx - x];
+					} else {
+						want = COLOUR_GREEN;
+					}
+					if(framebuffer_get_address(LED_MATRIX_ADDRESS_FROM_XY(gx, gy)) != want) {
+						fail("sprite", gx, gy);
+					}
+				}
+			}
+		}
+	}
+}
+
+int main(void) {
+	srand(1);
+	ledmatrix_setup();
+	init_palette();
+	check_addresses();
+	check_scrolling();
+	check_sprites();
+	printf("%s: orientation %d%s, %d panel(s), view %dx%d, field %d wide\n",
+			failures ? "FAIL" : "ok", DISPLAY_ORIENTATION, 
+			DISPLAY_MIRRORED ? " mirrored" : "", LEDMATRIX_NUM_PANELS,
+			VIEW_WIDTH, VIEW_HEIGHT, FIELD_WIDTH);
+	return failures != 0;
+}
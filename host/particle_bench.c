@@ -0,0 +1,83 @@
+/*
+ * particle_bench.c
+ *
+ * Written by Matt Burton
+ *
+ * Host benchmark for particles.c. Measures how many particle updates 
+ * (moves, including the erase and redraw in the framebuffer) the host 
+ * manages per millisecond, and checks that a burst of hits larger than
+ * the pool never moves more than PARTICLE_UPDATE_BUDGET particles in a 
+ * frame. The figures are for the host CPU, not the AVR.
+ */
+
+#include <stdio.h>
+#include "host.h"
+#include "timer0.h"
+#include "particles.h"
+#include "framebuffer.h"
+#include "palette.h"
+#include "viewport.h"
+#include "game.h"
+
+#define BENCH_FRAMES	2000000UL
+
+// Run one frame, returning the number of particles moved in it. (Every 
+// frame moves the smaller of the budget and the number alive.)
+static uint8_t run_frame(void) {
+	uint8_t alive = particles_alive();
+	
+	host_advance_time(PARTICLE_FRAME_MS);
+	particles_update(get_current_time());
+	return (alive < PARTICLE_UPDATE_BUDGET) ? alive : PARTICLE_UPDATE_BUDGET;
+}
+
+int main(void) {
+	uint32_t frame, updates = 0;
+	uint8_t moved, most = 0, frames;
+	uint64_t start, elapsed;
+	
+	ledmatrix_setup();
+	init_palette();
+	framebuffer_clear();
+	viewport_centre(FIELD_WIDTH / 2);
+	init_particles();
+	
+	// Overload - four hits at once asks for 32 particles from a pool of 
+	// MAX_PARTICLES
+	for(uint8_t i = 0; i < 4; i++) {
+		particles_burst(viewport_x + 2 + 4 * i, FIELD_HEIGHT / 2, COLOUR_ORANGE);
+	}
+	printf("burst of 4 hits: %u particles alive (pool %u)\n", 
+			particles_alive(), MAX_PARTICLES);
+	for(frames = 0; particles_alive(); frames++) {
+		moved = run_frame();
+		if(moved > most) {
+			most = moved;
+		}
+	}
+	printf("cleared after %u frames, at most %u moves per frame (budget %u)\n",
+			frames, most, PARTICLE_UPDATE_BUDGET);
+	if(most > PARTICLE_UPDATE_BUDGET) {
+		printf("FAIL: budget exceeded\n");
+		return 1;
+	}
+	
+	// Throughput - keep the pool topped up with a new burst whenever 
+	// there is room for one
+	start = host_microseconds();
+	for(frame = 0; frame < BENCH_FRAMES; frame++) {
+		if(particles_alive() <= MAX_PARTICLES - 8) {
+			particles_burst(viewport_x + (frame % VIEW_WIDTH), 
+					frame % FIELD_HEIGHT, COLOUR_ORANGE);
+		}
+		updates += run_frame();
+		if(frame % 16 == 0) {
+			(void)framebuffer_flush();
+		}
+	}
+	elapsed = host_microseconds() - start;
+	printf("%lu particle updates in %llu us: %.0f updates/ms (host)\n",
+			(unsigned long)updates, (unsigned long long)elapsed, 
+			updates * 1000.0 / elapsed);
+	return 0;
+}
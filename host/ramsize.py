@@ -0,0 +1,222 @@
+#!/usr/bin/env python3
+#
+# ramsize.py
+#
+# Written by Matt Burton
+#
+# Works out how much of the ATmega324A's static RAM (.data and .bss) the
+# game uses, without an AVR compiler. Each source file is compiled for
+# the host with debugging information, and every variable the compiler
+# puts in RAM is sized again with AVR type sizes (2 byte int and
+# pointers, 4 byte long, float and double, packed structures and short
+# enums, as the project's build uses). On the AVR, const data and string
+# literals which aren't in PROGMEM are copied into RAM too, so they are
+# counted. avr-libc's own data (the stdio stream pointers and the
+# random() state) is added at the end.
+#
+# Run from this directory:
+#	python3 ramsize.py [-v] [-DSYMBOL...] ../CSSE_Project/*.c
+# -v lists every variable. For the original tree it gives 596 bytes, the
+# sum of the .data, .bss and COMMON entries in Debug/CSSE_Project.map;
+# avr-size reports one more (.data 218 + .bss 379 = 597) as the linker
+# pads .data to an even length.
+
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+HOST_DIR = os.path.dirname(os.path.abspath(__file__))
+CFLAGS = ["-std=gnu99", "-O1", "-g", "-funsigned-char", "-fshort-enums",
+		"-fno-common", "-w", "-I" + HOST_DIR, "-include", "stdio.h",
+		"-DFDEV_SETUP_STREAM(put,get,rw)={0}", "-D_FDEV_SETUP_RW=0"]
+
+# avr-libc's RAM - __iob (stdin, stdout and stderr) and random()'s state
+LIBC_BYTES = 6 + 4
+
+# avr-libc's FILE is 14 bytes (the host's is much larger), and the
+# fixed width integer types are sized by name as the host's are built
+# from different base types (uint32_t is an unsigned int, for example)
+TYPEDEF_SIZES = {
+	"FILE": 14,
+	"int8_t": 1, "uint8_t": 1, "int16_t": 2, "uint16_t": 2,
+	"int32_t": 4, "uint32_t": 4, "int64_t": 8, "uint64_t": 8,
+}
+
+BASE_TYPE_SIZES = {
+	"char": 1, "signed char": 1, "unsigned char": 1, "_Bool": 1,
+	"short int": 2, "short unsigned int": 2,
+	"int": 2, "unsigned int": 2,
+	"long int": 4, "long unsigned int": 4,
+	"long long int": 8, "long long unsigned int": 8,
+	"float": 4, "double": 4, "long double": 4,
+}
+
+DIE_START = re.compile(r"^\s*<(\d+)><([0-9a-f]+)>: Abbrev Number: (\d+)(?: \((\w+)\))?")
+ATTRIBUTE = re.compile(r"^\s*<[0-9a-f]+>\s+(DW_AT_\w+)\s*:\s*(.*)$")
+
+
+def read_dies(obj):
+	"""Return the debugging information entries of an object file as a
+	dict of offset -> (tag, attributes, children)."""
+	output = subprocess.run(["readelf", "--debug-dump=info", "-wi", obj],
+			capture_output=True, text=True, check=True).stdout
+	dies = {}
+	stack = []
+	current = None
+	for line in output.splitlines():
+		m = DIE_START.match(line)
+		if m:
+			depth, offset, abbrev, tag = int(m.group(1)), int(m.group(2), 16), m.group(3), m.group(4)
+			del stack[depth:]
+			if abbrev == "0":
+				current = None
+				continue
+			current = (tag, {}, [])
+			dies[offset] = current
+			if stack:
+				stack[-1][2].append(offset)
+			stack.append(current)
+			continue
+		m = ATTRIBUTE.match(line)
+		if m and current is not None:
+			current[1][m.group(1)] = m.group(2).strip()
+	return dies
+
+
+def attribute_name(value):
+	# Names are either given directly or as "(indirect string, ...): name"
+	return value.split("): ")[-1] if "): " in value else value
+
+
+def reference(value):
+	m = re.search(r"<0x([0-9a-f]+)>", value)
+	return int(m.group(1), 16) if m else None
+
+
+def number(value):
+	m = re.match(r"(-?(?:0x[0-9a-f]+|\d+))", value)
+	return int(m.group(1), 0) if m else None
+
+
+def avr_size(dies, offset):
+	if offset is None:
+		return 0
+	tag, attributes, children = dies[offset]
+	if tag == "DW_TAG_base_type":
+		return BASE_TYPE_SIZES[attribute_name(attributes["DW_AT_name"])]
+	if tag == "DW_TAG_pointer_type":
+		return 2
+	if tag == "DW_TAG_enumeration_type":
+		return number(attributes["DW_AT_byte_size"])
+	if tag == "DW_TAG_typedef" and attribute_name(attributes["DW_AT_name"]) in TYPEDEF_SIZES:
+		return TYPEDEF_SIZES[attribute_name(attributes["DW_AT_name"])]
+	if tag in ("DW_TAG_typedef", "DW_TAG_const_type", "DW_TAG_volatile_type"):
+		return avr_size(dies, reference(attributes.get("DW_AT_type", "")))
+	if tag == "DW_TAG_structure_type":
+		return sum(avr_size(dies, reference(dies[c][1]["DW_AT_type"]))
+				for c in children if dies[c][0] == "DW_TAG_member")
+	if tag == "DW_TAG_union_type":
+		return max(avr_size(dies, reference(dies[c][1]["DW_AT_type"]))
+				for c in children if dies[c][0] == "DW_TAG_member")
+	if tag == "DW_TAG_array_type":
+		count = 1
+		for c in children:
+			ca = dies[c][1]
+			if "DW_AT_count" in ca:
+				count *= number(ca["DW_AT_count"])
+			elif "DW_AT_upper_bound" in ca:
+				count *= number(ca["DW_AT_upper_bound"]) + 1
+			else:
+				count = 0
+		return count * avr_size(dies, reference(attributes["DW_AT_type"]))
+	raise ValueError("can't size " + tag)
+
+
+def variable_types(dies):
+	"""Map each variable name to the types of the variables of that name
+	which have storage."""
+	types = {}
+	for tag, attributes, children in dies.values():
+		if tag != "DW_TAG_variable" or "DW_AT_location" not in attributes:
+			continue
+		if "DW_AT_specification" in attributes:
+			spec = dies[reference(attributes["DW_AT_specification"])][1]
+			name, type = spec.get("DW_AT_name"), spec.get("DW_AT_type")
+		else:
+			name, type = attributes.get("DW_AT_name"), attributes.get("DW_AT_type")
+		if name and type:
+			types.setdefault(attribute_name(name), []).append(reference(type))
+	return types
+
+
+def sections(obj):
+	output = subprocess.run(["readelf", "-SW", obj], capture_output=True,
+			text=True, check=True).stdout
+	result = {}
+	for m in re.finditer(r"\[\s*(\d+)\]\s+(\S+)\s+\S+\s+[0-9a-f]+\s+[0-9a-f]+\s+([0-9a-f]+)", output):
+		result[int(m.group(1))] = (m.group(2), int(m.group(3), 16))
+	return result
+
+
+def in_ram(section):
+	if section.startswith(".rodata.str") or section.startswith(".rodata.cst"):
+		return False
+	return section.startswith((".data", ".bss", ".rodata"))
+
+
+def ram_variables(obj):
+	"""Return [(name, avr bytes)] for the variables in RAM, plus the bytes
+	of string literals."""
+	dies = read_dies(obj)
+	types = variable_types(dies)
+	section_table = sections(obj)
+	output = subprocess.run(["readelf", "-sW", obj], capture_output=True,
+			text=True, check=True).stdout
+	variables = []
+	for line in output.splitlines():
+		fields = line.split()
+		if len(fields) < 8 or fields[3] != "OBJECT" or not fields[6].isdigit():
+			continue
+		section = section_table[int(fields[6])][0]
+		if not in_ram(section):
+			continue
+		name = fields[7].split(".")[0]
+		if name not in types or not types[name]:
+			raise ValueError("no type for " + fields[7] + " in " + obj)
+		variables.append((fields[7], avr_size(dies, types[name].pop(0))))
+	strings = sum(size for name, size in section_table.values()
+			if name.startswith(".rodata.str"))
+	return variables, strings
+
+
+def main():
+	args = sys.argv[1:]
+	verbose = "-v" in args
+	defines = [a for a in args if a.startswith("-D")]
+	sources = [a for a in args if a.endswith(".c")]
+	total = 0
+	with tempfile.TemporaryDirectory() as build:
+		for source in sources:
+			obj = os.path.join(build, os.path.basename(source) + ".o")
+			subprocess.run(["gcc"] + CFLAGS + defines + 
+					["-I" + os.path.dirname(os.path.abspath(source)), "-c", source, "-o", obj],
+					check=True)
+			variables, strings = ram_variables(obj)
+			file_total = sum(size for name, size in variables) + strings
+			total += file_total
+			if file_total == 0:
+				continue
+			print("%5d  %s" % (file_total, os.path.basename(source)))
+			if verbose:
+				for name, size in sorted(variables, key=lambda v: -v[1]):
+					print("       %5d  %s" % (size, name))
+				if strings:
+					print("       %5d  (string literals)" % strings)
+	print("%5d  avr-libc" % LIBC_BYTES)
+	print("%5d  total static RAM of 2048" % (total + LIBC_BYTES))
+
+
+if __name__ == "__main__":
+	main()
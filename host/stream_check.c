@@ -0,0 +1,109 @@
+/*
+ * stream_check.c
+ *
+ * Written by Matt Burton
+ *
+ * Host check of the display stream (framestream.h). The game itself
+ * (project.c's new_game() and play_game()) is played by the autopilot
+ * with the stream on (for at most GAME_MS), and port 1's output is 
+ * kept in a file. Once the game is over the stream is given time to 
+ * send anything it put off, and then the file is decoded as the host 
+ * viewer (stream_view.c) would. The decoded display must match the framebuffer, no frame may
+ * be missing, and the frame sizes are reported against what the port
+ * can carry. The game's own terminal output goes to stdout, the results
+ * to stderr. Given a file name, the stream is kept in that file (for 
+ * trying stream_view with).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "host.h"
+#include "timer0.h"
+#include "framebuffer.h"
+#include "framestream.h"
+#include "telemetry.h"
+#include "telemetry_reader.h"
+#include "autopilot.h"
+#include "params.h"
+#include "game.h"
+#include "score.h"
+#include "lives.h"
+
+#define SEED			1234
+#define GAME_MS			600000UL
+#define DRAIN_MS		(20 * FRAMESTREAM_FRAME_MS)
+
+// What the port can carry in one frame time (10 bits per byte)
+#define BUDGET_BYTES	(TELEMETRY_BAUD / 10 * FRAMESTREAM_FRAME_MS / 1000)
+
+// project.c
+void initialise_hardware(void);
+void new_game(void);
+void play_game(void);
+
+static void end_game(void) {
+	subtract_lives(get_lives());
+}
+
+int main(int argc, char** argv) {
+	FILE* stream = (argc > 1) ? fopen(argv[1], "w+b") : tmpfile();
+	TelemetryReader reader;
+	uint32_t end_time, keyframes = 0, bytes = 0, largest = 0;
+	uint16_t mismatches = 0;
+	int c;
+
+	if(!stream) {
+		perror(argc > 1 ? argv[1] : "tmpfile");
+		return 1;
+	}
+	initialise_hardware();
+	host_serial_connect(SERIAL_PORT0, -1, 1);
+	host_serial_connect(TELEMETRY_PORT, -1, fileno(stream));
+	(void)param_set(PARAM_TELEMETRY, 1);
+	srandom(SEED);
+	autopilot_set_mode(AUTOPILOT_ON);
+	framestream_enable(1);
+	host_set_alarm(GAME_MS, end_game);
+	new_game();
+	play_game();
+
+	// Let the stream catch up
+	end_time = get_current_time() + DRAIN_MS;
+	while(get_current_time() < end_time) {
+		(void)framebuffer_flush();
+		framestream_update(get_current_time());
+		host_advance_time(10);
+	}
+
+	rewind(stream);
+	telemetry_reader_init(&reader);
+	while((c = getc(stream)) != EOF) {
+		if(telemetry_reader_byte(&reader, c) == TELEMETRY_FRAME) {
+			keyframes += (reader.frame_type == 'K');
+			bytes += 4 + reader.packet[3];
+			if(4 + reader.packet[3] > largest) {
+				largest = 4 + reader.packet[3];
+			}
+		}
+	}
+	for(uint8_t x = 0; x < MATRIX_TOTAL_COLUMNS; x++) {
+		for(uint8_t y = 0; y < MATRIX_NUM_ROWS; y++) {
+			mismatches += (reader.display[x][y] != framebuffer_get_pixel(x, y));
+		}
+	}
+
+	fprintf(stderr, "game: score %lu, %lu ms, %u ticks\n",
+			(unsigned long)get_score(), (unsigned long)get_current_time(),
+			get_tick_number());
+	fprintf(stderr, "stream: %lu frames (%lu keyframes), %lu missing, %lu log records, "
+			"%lu bytes skipped, %u deferred\n",
+			(unsigned long)reader.frames, (unsigned long)keyframes,
+			(unsigned long)reader.lost_frames, (unsigned long)reader.log_records,
+			(unsigned long)reader.skipped, framestream_deferred_frames());
+	fprintf(stderr, "frame bytes: mean %.1f, largest %lu, port budget %u per frame\n",
+			(double)bytes / reader.frames, (unsigned long)largest, BUDGET_BYTES);
+	fprintf(stderr, "%s: display stream, %d panel(s), %u pixels differ\n",
+			(mismatches || reader.lost_frames || reader.skipped) ? "FAIL" : "ok",
+			LEDMATRIX_NUM_PANELS, mismatches);
+	return mismatches || reader.lost_frames || reader.skipped;
+}
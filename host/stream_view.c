@@ -0,0 +1,68 @@
+/*
+ * stream_view.c
+ *
+ * Written by Matt Burton
+ *
+ * Host viewer for the display stream (see framestream.h). Reads the
+ * board's telemetry (see telemetry.h) from a file or serial device, or
+ * from standard input, and redraws the display in the terminal after
+ * every frame - row 7 at the top, as on the board. With the board on
+ * /dev/ttyUSB1, for example:
+ *	stty -F /dev/ttyUSB1 76800 raw && ./stream_view /dev/ttyUSB1
+ * (The board's telemetry parameter must be on and the stream started
+ * with the 'v' key.) Build it with the same LEDMATRIX_NUM_PANELS as the
+ * board.
+ */
+
+#include <stdio.h>
+#include "telemetry_reader.h"
+
+// The terminal background colour for a pixel colour (4 bits each of red
+// and green), as the board's terminal view (termview.c) shows it
+static uint8_t background(PixelColour colour) {
+	uint8_t red = colour & 0x0F;
+	uint8_t green = colour >> 4;
+
+	if(red == 0 && green == 0) {
+		return 40;
+	} else if(red >= 2 * green) {
+		return 41;
+	} else if(green >= 2 * red) {
+		return 42;
+	}
+	return 43;
+}
+
+static void draw(const TelemetryReader* reader) {
+	printf("\x1b[H");
+	for(uint8_t y = MATRIX_NUM_ROWS; y-- > 0; ) {
+		for(uint8_t x = 0; x < MATRIX_TOTAL_COLUMNS; x++) {
+			printf("\x1b[%um  ", background(reader->display[x][y]));
+		}
+		printf("\x1b[0m\n");
+	}
+	printf("frame %3u (%c) - %lu frames, %lu missing, %lu log records\x1b[K\n",
+			reader->frame_number, reader->frame_type,
+			(unsigned long)reader->frames, (unsigned long)reader->lost_frames,
+			(unsigned long)reader->log_records);
+	fflush(stdout);
+}
+
+int main(int argc, char** argv) {
+	FILE* input = stdin;
+	TelemetryReader reader;
+	int c;
+
+	if(argc > 1 && !(input = fopen(argv[1], "rb"))) {
+		perror(argv[1]);
+		return 1;
+	}
+	telemetry_reader_init(&reader);
+	printf("\x1b[2J");
+	while((c = getc(input)) != EOF) {
+		if(telemetry_reader_byte(&reader, c) == TELEMETRY_FRAME) {
+			draw(&reader);
+		}
+	}
+	return 0;
+}
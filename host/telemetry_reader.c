@@ -0,0 +1,138 @@
+/*
+ * telemetry_reader.c
+ *
+ * Written by Matt Burton
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "telemetry_reader.h"
+#include "framestream.h"
+#include "log.h"
+
+#define FRAME_HEADER_BYTES	4
+#define NUM_PIXELS			(MATRIX_TOTAL_COLUMNS * MATRIX_NUM_ROWS)
+
+#define LOG_MESSAGE(id, format)	[id] = format,
+static const char* formats[] = {
+#include "log_ids.h"
+};
+#undef LOG_MESSAGE
+
+static void apply_frame(TelemetryReader* reader);
+
+void telemetry_reader_init(TelemetryReader* reader) {
+	memset(reader, 0, sizeof(*reader));
+}
+
+uint8_t telemetry_reader_byte(TelemetryReader* reader, uint8_t byte) {
+	int8_t args;
+
+	if(reader->length == 0) {
+		if(byte != FRAMESTREAM_MARKER && byte != LOG_MARKER) {
+			reader->skipped++;
+			return TELEMETRY_NOTHING;
+		}
+		// The rest of the header says how long it is
+		reader->needed = 2;
+	}
+	reader->packet[reader->length++] = byte;
+	if(reader->length < reader->needed) {
+		return TELEMETRY_NOTHING;
+	}
+	if(reader->packet[0] == LOG_MARKER) {
+		args = log_message_args(reader->packet[1]);
+		if(args < 0) {
+			// Not a record after all
+			reader->skipped += reader->length;
+			reader->length = 0;
+			return TELEMETRY_NOTHING;
+		}
+		if(reader->length < 2 + 2 * args) {
+			reader->needed = 2 + 2 * args;
+			return TELEMETRY_NOTHING;
+		}
+		reader->log_id = reader->packet[1];
+		for(int8_t i = 0; i < 2; i++) {
+			reader->log_args[i] = (i < args) ? reader->packet[2 + 2 * i] |
+					(reader->packet[3 + 2 * i] << 8) : 0;
+		}
+		reader->log_records++;
+		reader->length = 0;
+		return TELEMETRY_LOG;
+	}
+	if(reader->length == 2 && reader->packet[1] != 'K' && reader->packet[1] != 'D') {
+		reader->skipped += reader->length;
+		reader->length = 0;
+		return TELEMETRY_NOTHING;
+	}
+	if(reader->length < FRAME_HEADER_BYTES) {
+		reader->needed = FRAME_HEADER_BYTES;
+		return TELEMETRY_NOTHING;
+	}
+	if(reader->length < FRAME_HEADER_BYTES + reader->packet[3]) {
+		reader->needed = FRAME_HEADER_BYTES + reader->packet[3];
+		return TELEMETRY_NOTHING;
+	}
+	apply_frame(reader);
+	reader->length = 0;
+	return TELEMETRY_FRAME;
+}
+
+int8_t log_message_args(uint8_t id) {
+	const char* format = log_message_format(id);
+	int8_t args = 0;
+
+	if(!format) {
+		return -1;
+	}
+	for(; *format; format++) {
+		if(*format == '%') {
+			args++;
+		}
+	}
+	return args;
+}
+
+const char* log_message_format(uint8_t id) {
+	return (id < NUM_LOG_MESSAGES) ? formats[id] : 0;
+}
+
+int telemetry_reader_log_text(const TelemetryReader* reader, char* text, 
+		size_t size) {
+	return snprintf(text, size, log_message_format(reader->log_id),
+			reader->log_args[0], reader->log_args[1]);
+}
+
+// Run through the frame's (skip, count, colour) runs, in stream order
+// (see framestream.h).
+static void apply_frame(TelemetryReader* reader) {
+	const uint8_t* run = reader->packet + FRAME_HEADER_BYTES;
+	const uint8_t* end = run + reader->packet[3];
+	uint16_t p = 0;
+
+	reader->frame_type = reader->packet[1];
+	if(reader->have_frame) {
+		reader->lost_frames += (uint8_t)(reader->packet[2] - reader->frame_number - 1);
+	}
+	reader->frame_number = reader->packet[2];
+	reader->have_frame = 1;
+	reader->frames++;
+	if(reader->frame_type == 'K') {
+		memset(reader->display, COLOUR_BLACK, sizeof(reader->display));
+	}
+	while(end - run >= 2) {
+		p += run[0];
+		if(run[1] == 0) {
+			run += 2;
+			continue;
+		}
+		if(end - run < 3) {
+			break;
+		}
+		for(uint8_t i = 0; i < run[1] && p < NUM_PIXELS; i++, p++) {
+			reader->display[p / MATRIX_NUM_ROWS][p % MATRIX_NUM_ROWS] = run[2];
+		}
+		run += 3;
+	}
+}
@@ -0,0 +1,65 @@
+/*
+ * telemetry_reader.h
+ *
+ * Author: Matt Burton
+ *
+ * Host side decoding of the board's telemetry output (see telemetry.h)
+ * - display stream packets (framestream.h) and log records (log.h).
+ * Bytes are passed in one at a time, as they arrive. Display packets
+ * are applied to a copy of the display, and a log record's argument
+ * count is taken from its format string in log_ids.h. Bytes which
+ * can't start a packet or a record are skipped (and counted), so the
+ * reader can start part way through the stream.
+ */
+
+#ifndef TELEMETRY_READER_H_
+#define TELEMETRY_READER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "ledmatrix.h"
+
+// Returned by telemetry_reader_byte()
+#define TELEMETRY_NOTHING	0
+#define TELEMETRY_FRAME		1
+#define TELEMETRY_LOG		2
+
+typedef struct {
+	// The display as the stream has drawn it, indexed as MatrixData
+	PixelColour display[MATRIX_TOTAL_COLUMNS][MATRIX_NUM_ROWS];
+
+	// The last frame's type ('K' or 'D') and number, and the last log
+	// record's ID and arguments
+	uint8_t frame_type;
+	uint8_t frame_number;
+	uint8_t log_id;
+	uint16_t log_args[2];
+
+	// Counts of frames, frames missing from the sequence, log records
+	// and skipped bytes
+	uint32_t frames;
+	uint32_t lost_frames;
+	uint32_t log_records;
+	uint32_t skipped;
+
+	// The packet being read
+	uint8_t packet[4 + 255];
+	uint16_t length;
+	uint16_t needed;
+	uint8_t have_frame;
+} TelemetryReader;
+
+void telemetry_reader_init(TelemetryReader* reader);
+uint8_t telemetry_reader_byte(TelemetryReader* reader, uint8_t byte);
+
+// The number of arguments of a log message (-1 if the ID is unknown),
+// and its format string (0 if unknown).
+int8_t log_message_args(uint8_t id);
+const char* log_message_format(uint8_t id);
+
+// Write the last log record's text (without a newline) into text, as
+// snprintf() would, returning its length.
+int telemetry_reader_log_text(const TelemetryReader* reader, char* text, 
+		size_t size);
+
+#endif /* TELEMETRY_READER_H_ */
@@ -0,0 +1,143 @@
+/*
+ * termview_check.c
+ *
+ * Written by Matt Burton
+ *
+ * Host check of the terminal view (termview.h). Random pixels are drawn
+ * for a number of frames while the view is on, its output (port 0) is
+ * played back on a simulated terminal, and the terminal must end up
+ * showing what the framebuffer holds. Turning the view off must leave
+ * its part of the terminal blank.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "host.h"
+#include "framebuffer.h"
+#include "palette.h"
+#include "termview.h"
+#include "serialio.h"
+
+#define FRAMES			200
+#define CHANGES			12
+#define CATCH_UP_FRAMES	100
+#define SCREEN_ROWS		(TERMVIEW_ROW + MATRIX_NUM_ROWS + 1)
+#define SCREEN_COLUMNS	(TERMVIEW_COLUMN + MATRIX_TOTAL_COLUMNS * TERMVIEW_CELL_WIDTH + 1)
+
+// The simulated terminal - the background colour (40 to 43) of each
+// character position, 1 based as the escape sequences are
+static uint8_t screen[SCREEN_ROWS + 1][SCREEN_COLUMNS + 1];
+static uint8_t row = 1, column = 1, background = 40;
+static uint16_t bad_sequences;
+
+// Play the output back on the terminal
+static void play(FILE* output) {
+	int c, number, numbers[2], count;
+
+	rewind(output);
+	while((c = getc(output)) != EOF) {
+		if(c == ' ') {
+			if(row <= SCREEN_ROWS && column <= SCREEN_COLUMNS) {
+				screen[row][column] = background;
+			}
+			column++;
+			continue;
+		}
+		if(c != '\x1b' || getc(output) != '[') {
+			bad_sequences++;
+			continue;
+		}
+		count = 0;
+		number = -1;
+		while((c = getc(output)) != EOF && ((c >= '0' && c <= '9') || c == ';')) {
+			if(c == ';') {
+				numbers[count++ & 1] = number;
+				number = -1;
+			} else {
+				number = (number < 0 ? 0 : number * 10) + c - '0';
+			}
+		}
+		numbers[count++ & 1] = number;
+		switch(c) {
+			case 'H':	row = numbers[0];	column = numbers[1];	break;
+			case 'B':	row += (number < 0) ? 1 : number;			break;
+			case 'C':	column += (number < 0) ? 1 : number;		break;
+			case 'D':	column -= (number < 0) ? 1 : number;		break;
+			case 'm':	background = (number <= 0) ? 40 : number;	break;
+			default:	bad_sequences++;
+		}
+	}
+	rewind(output);
+	(void)ftruncate(fileno(output), 0);
+}
+
+// The number of cells which don't show what they should
+static uint16_t differences(uint8_t enabled) {
+	uint16_t count = 0;
+	PixelColour colour;
+	uint8_t expected, red, green;
+
+	for(uint8_t x = 0; x < MATRIX_TOTAL_COLUMNS; x++) {
+		for(uint8_t y = 0; y < MATRIX_NUM_ROWS; y++) {
+			colour = enabled ? framebuffer_get_pixel(x, y) : COLOUR_BLACK;
+			red = colour & 0x0F;
+			green = colour >> 4;
+			expected = (colour == COLOUR_BLACK) ? 40 : (red >= 2 * green) ? 41 :
+					(green >= 2 * red) ? 42 : 43;
+			for(uint8_t i = 0; i < TERMVIEW_CELL_WIDTH; i++) {
+				count += screen[TERMVIEW_ROW + MATRIX_NUM_ROWS - 1 - y]
+						[TERMVIEW_COLUMN + x * TERMVIEW_CELL_WIDTH + i] != expected;
+			}
+		}
+	}
+	return count;
+}
+
+int main(void) {
+	FILE* output = tmpfile();
+	uint32_t time = 0;
+	uint16_t on_differences, off_differences, deferred;
+
+	for(uint8_t r = 1; r <= SCREEN_ROWS; r++) {
+		for(uint8_t c = 1; c <= SCREEN_COLUMNS; c++) {
+			screen[r][c] = 40;
+		}
+	}
+	host_serial_connect(SERIAL_PORT0, -1, fileno(output));
+	ledmatrix_setup();
+	init_palette();
+	framebuffer_clear();
+	termview_enable(1);
+	termview_invalidate();
+	srand(2);
+	for(uint16_t frame = 0; frame < FRAMES; frame++) {
+		for(uint8_t i = 0; i < CHANGES; i++) {
+			framebuffer_set_pixel(rand() % MATRIX_TOTAL_COLUMNS,
+					rand() % MATRIX_NUM_ROWS, (rand() % 3) ? rand() % 256 : COLOUR_BLACK);
+		}
+		(void)framebuffer_flush();
+		termview_update(time += TERMVIEW_FRAME_MS);
+		play(output);
+	}
+	// Let the view catch up
+	for(uint8_t frame = 0; frame < CATCH_UP_FRAMES; frame++) {
+		termview_update(time += TERMVIEW_FRAME_MS);
+		play(output);
+	}
+	on_differences = differences(1);
+	deferred = termview_deferred_frames();
+
+	termview_enable(0);
+	for(uint8_t frame = 0; frame < CATCH_UP_FRAMES; frame++) {
+		termview_update(time += TERMVIEW_FRAME_MS);
+		play(output);
+	}
+	off_differences = differences(0);
+
+	printf("%s: terminal view, %d panel(s), %u deferred frames, %u cells wrong "
+			"on, %u off\n", (on_differences || off_differences || bad_sequences) ?
+			"FAIL" : "ok", LEDMATRIX_NUM_PANELS, deferred,
+			on_differences, off_differences);
+	return on_differences || off_differences || bad_sequences;
+}
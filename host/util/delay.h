@@ -0,0 +1,17 @@
+/*
+ * util/delay.h (host)
+ *
+ * Written by Matt Burton
+ *
+ * Busy waits move the simulated clock on (see host.h) instead.
+ */
+
+#ifndef HOST_UTIL_DELAY_H_
+#define HOST_UTIL_DELAY_H_
+
+#include "host.h"
+
+#define _delay_ms(ms)	host_advance_time((uint32_t)(ms))
+#define _delay_us(us)	do { } while(0)
+
+#endif /* HOST_UTIL_DELAY_H_ */